@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <stdio.h>
+#include <stdlib.h>
+#include "apply.h"
+#include "environment.h"
+#include "xml.h"
+
+static void
+set_value_num(GSettings *settings, const char *key, int value)
+{
+	g_settings_set_value(settings, key, g_variant_new("i", value));
+}
+
+static void
+set_value(GSettings *settings, const char *key, const char *value)
+{
+	if (!value) {
+		fprintf(stderr, "warn: cannot set '%s' - no value specified\n", key);
+		return;
+	}
+	g_settings_set_value(settings, key, g_variant_new("s", value));
+}
+
+static void
+write_value(struct apply *apply, enum backend backend, const char *key, bool integer,
+		const char *value)
+{
+	switch (backend) {
+	case BACKEND_XML:
+		if (value) {
+			xml_set((char *)key, (char *)value);
+		}
+		break;
+	case BACKEND_GSETTINGS:
+		if (!apply->settings) {
+			break;
+		}
+		if (integer) {
+			set_value_num(apply->settings, key, value ? atoi(value) : 0);
+		} else {
+			set_value(apply->settings, key, value);
+		}
+		break;
+	case BACKEND_ENVIRONMENT:
+		if (value) {
+			environment_set(key, value);
+		} else {
+			environment_unset(key);
+		}
+		break;
+	case BACKEND_THEMERC_OVERRIDE:
+		if (value) {
+			kvfile_set(apply->themerc_override, key, value);
+		} else {
+			kvfile_unset(apply->themerc_override, key);
+		}
+		break;
+	case BACKEND_NR:
+		break;
+	}
+}
+
+bool
+apply_value(struct apply *apply, enum backend backend, const char *key, bool integer,
+		char **snapshot, char *value)
+{
+	if (!g_strcmp0(value, *snapshot)) {
+		g_free(value);
+		return false;
+	}
+	write_value(apply, backend, key, integer, value);
+	apply->changed[backend] = true;
+	g_free(*snapshot);
+	*snapshot = value;
+	return true;
+}
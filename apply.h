@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef APPLY_H
+#define APPLY_H
+#include <gio/gio.h>
+#include <stdbool.h>
+#include "kvfile.h"
+
+enum backend {
+	BACKEND_XML = 0,
+	BACKEND_GSETTINGS,
+	BACKEND_ENVIRONMENT,
+	BACKEND_THEMERC_OVERRIDE,
+	BACKEND_NR
+};
+
+/*
+ * The GTK-free part of update(): values are compared with a snapshot and
+ * written to the backends if they have changed. Strings passed in are always
+ * owned by the snapshot or freed, so nothing is leaked however often this is
+ * called.
+ */
+struct apply {
+	GSettings *settings; /* may be NULL */
+	struct kvfile *themerc_override;
+	bool changed[BACKEND_NR];
+};
+
+/**
+ * apply_value - write @value to @backend if it differs from *@snapshot
+ * @integer: write a gsettings key as "i" rather than "s"
+ * @snapshot: value as loaded or last applied, replaced by @value on change
+ * @value: newly allocated string, or NULL for unset. NULL leaves rc.xml and
+ *	   gsettings untouched but removes environment variables and overrides.
+ * Returns true if the value has changed
+ */
+bool apply_value(struct apply *apply, enum backend backend, const char *key,
+	bool integer, char **snapshot, char *value);
+
+#endif /* APPLY_H */
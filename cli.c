@@ -0,0 +1,487 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "apply.h"
+#include "cli.h"
+#include "environment.h"
+#include "kvfile.h"
+#include "reconfigure.h"
+#include "theme.h"
+#include "xml.h"
+
+enum option {
+	OPTION_GET = 0,
+	OPTION_SET,
+	OPTION_LIST_THEMES,
+	OPTION_APPLY,
+	OPTION_NR
+};
+
+static const struct {
+	const char *name;
+	bool has_arg;
+} options[OPTION_NR] = {
+	[OPTION_GET] = { "--get", true },
+	[OPTION_SET] = { "--set", true },
+	[OPTION_LIST_THEMES] = { "--list-themes", true },
+	[OPTION_APPLY] = { "--apply", false },
+};
+
+struct command {
+	enum option option;
+	const char *arg;
+};
+
+/* the rc.xml path is used as it is, the others have their prefix removed */
+static const struct {
+	const char *prefix;
+	enum backend backend;
+} prefixes[] = {
+	{ "/", BACKEND_XML },
+	{ "gsettings/", BACKEND_GSETTINGS },
+	{ "environment/", BACKEND_ENVIRONMENT },
+	{ "themerc-override/", BACKEND_THEMERC_OVERRIDE },
+};
+
+/* as passed to theme_find() by the pages */
+static const struct {
+	const char *kind;
+	const char *middle;
+	const char *end;
+} theme_kinds[] = {
+	{ "openbox", "themes", "openbox-3/themerc" },
+	{ "gtk", "themes", "gtk-3.0/gtk.css" },
+	{ "icon", "icons", NULL },
+	{ "cursor", "icons", "cursors" },
+};
+
+struct cli {
+	bool loaded[BACKEND_NR];
+	GSettings *settings;
+	struct kvfile themerc_override;
+	struct apply apply;
+	bool gtk_theme_changed;
+};
+
+static const char usage[] =
+	"Usage: labwc-tweaks-gtk [--get PATH] [--set PATH=VALUE] [--list-themes KIND] [--apply]\n"
+	"PATH is /labwc_config/..., environment/KEY, themerc-override/KEY or gsettings/KEY\n"
+	"KIND is openbox, gtk, icon or cursor\n";
+
+/* returns the option @arg names and sets @value to what follows '=', if anything */
+static int
+find_option(const char *arg, const char **value)
+{
+	for (int i = 0; i < OPTION_NR; i++) {
+		size_t len = strlen(options[i].name);
+		if (strncmp(arg, options[i].name, len)) {
+			continue;
+		}
+		if (!arg[len]) {
+			*value = NULL;
+			return i;
+		}
+		if (arg[len] == '=' && options[i].has_arg) {
+			*value = arg + len + 1;
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool
+cli_wanted(int argc, char **argv)
+{
+	const char *value;
+	for (int i = 1; i < argc; i++) {
+		if (find_option(argv[i], &value) >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* returns the key within the backend, or NULL if @path names none */
+static const char *
+parse_path(const char *path, enum backend *backend)
+{
+	for (size_t i = 0; i < G_N_ELEMENTS(prefixes); i++) {
+		size_t len = strlen(prefixes[i].prefix);
+		if (strncmp(path, prefixes[i].prefix, len) || !path[len]) {
+			continue;
+		}
+		*backend = prefixes[i].backend;
+		return *backend == BACKEND_XML ? path : path + len;
+	}
+	fprintf(stderr, "warn: unknown path '%s'\n", path);
+	return NULL;
+}
+
+static char *
+config_filename(const char *name)
+{
+	return g_build_filename(g_get_home_dir(), ".config", "labwc", name, NULL);
+}
+
+/* as kvfile_init(), a missing rc.xml is created but an unreadable one fails */
+static bool
+xml_load(const char *filename)
+{
+	char *contents = NULL;
+	gsize length = 0;
+	GError *err = NULL;
+	if (!g_file_get_contents(filename, &contents, &length, &err)) {
+		bool missing = g_error_matches(err, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+		if (!missing) {
+			fprintf(stderr, "warn: %s\n", err->message);
+		}
+		g_error_free(err);
+		if (!missing) {
+			return false;
+		}
+	}
+	xml_init_from_data(filename, contents, (int)length);
+	g_free(contents);
+	return true;
+}
+
+/*
+ * Only the files which are needed are read. A file which exists but cannot be
+ * read fails every command using it, so that it is never written over.
+ */
+static bool
+load(struct cli *cli, enum backend backend)
+{
+	if (cli->loaded[backend]) {
+		return true;
+	}
+	char *filename = NULL;
+	GSettingsSchemaSource *source;
+	GSettingsSchema *schema;
+	bool ret = true;
+
+	switch (backend) {
+	case BACKEND_XML:
+		filename = config_filename("rc.xml");
+		ret = xml_load(filename);
+		break;
+	case BACKEND_GSETTINGS:
+		/* g_settings_new() aborts if the schema is not installed */
+		source = g_settings_schema_source_get_default();
+		schema = source ? g_settings_schema_source_lookup(source,
+			"org.gnome.desktop.interface", TRUE) : NULL;
+		if (!schema) {
+			fprintf(stderr, "warn: org.gnome.desktop.interface is not installed\n");
+			return false;
+		}
+		g_settings_schema_unref(schema);
+		cli->settings = g_settings_new("org.gnome.desktop.interface");
+		cli->apply.settings = cli->settings;
+		break;
+	case BACKEND_ENVIRONMENT:
+		filename = config_filename("environment");
+		ret = environment_init(filename);
+		break;
+	case BACKEND_THEMERC_OVERRIDE:
+		filename = config_filename("themerc-override");
+		kvfile_finish(&cli->themerc_override);
+		ret = kvfile_init(&cli->themerc_override, filename, ':');
+		break;
+	case BACKEND_NR:
+		break;
+	}
+	g_free(filename);
+	cli->loaded[backend] = ret;
+	return ret;
+}
+
+/* returns the current value as a GVariant, or NULL if @key does not exist */
+static GVariant *
+gsettings_value(struct cli *cli, const char *key)
+{
+	GSettingsSchema *schema = NULL;
+	g_object_get(cli->settings, "settings-schema", &schema, NULL);
+	bool found = schema && g_settings_schema_has_key(schema, key);
+	if (schema) {
+		g_settings_schema_unref(schema);
+	}
+	if (!found) {
+		fprintf(stderr, "warn: no gsettings key '%s'\n", key);
+		return NULL;
+	}
+	return g_settings_get_value(cli->settings, key);
+}
+
+/* returns a newly allocated string, or NULL if unset */
+static char *
+get_value(struct cli *cli, enum backend backend, const char *key)
+{
+	char buffer[4096] = { 0 };
+	GVariant *variant;
+	char *value = NULL;
+
+	switch (backend) {
+	case BACKEND_XML:
+		return g_strdup(xml_get((char *)key));
+	case BACKEND_GSETTINGS:
+		variant = gsettings_value(cli, key);
+		if (!variant) {
+			return NULL;
+		}
+		if (g_variant_is_of_type(variant, G_VARIANT_TYPE_STRING)) {
+			value = g_variant_dup_string(variant, NULL);
+		} else {
+			value = g_variant_print(variant, FALSE);
+		}
+		g_variant_unref(variant);
+		return value;
+	case BACKEND_ENVIRONMENT:
+		environment_get(buffer, sizeof(buffer), key);
+		return *buffer ? g_strdup(buffer) : NULL;
+	case BACKEND_THEMERC_OVERRIDE:
+		return g_strdup(kvfile_get(&cli->themerc_override, key));
+	case BACKEND_NR:
+		break;
+	}
+	return NULL;
+}
+
+static bool
+get(struct cli *cli, const char *path)
+{
+	enum backend backend;
+	const char *key = parse_path(path, &backend);
+	if (!key || !load(cli, backend)) {
+		return false;
+	}
+	char *value = get_value(cli, backend, key);
+	if (!value) {
+		return false;
+	}
+	printf("%s\n", value);
+	g_free(value);
+	return true;
+}
+
+/* gsettings keys are written as strings or, like cursor-size, as integers */
+static bool
+gsettings_check(struct cli *cli, const char *key, const char *value, bool *integer)
+{
+	GVariant *variant = gsettings_value(cli, key);
+	if (!variant) {
+		return false;
+	}
+	*integer = g_variant_is_of_type(variant, G_VARIANT_TYPE_INT32);
+	bool string = g_variant_is_of_type(variant, G_VARIANT_TYPE_STRING);
+	g_variant_unref(variant);
+	if (!*integer && !string) {
+		fprintf(stderr, "warn: cannot set gsettings key '%s' of this type\n", key);
+		return false;
+	}
+	if (!*integer) {
+		return true;
+	}
+	char *end;
+	errno = 0;
+	long number = strtol(value, &end, 10);
+	if (errno || !*value || *end || number != (gint32)number) {
+		fprintf(stderr, "warn: '%s' is not a number\n", value);
+		return false;
+	}
+	return true;
+}
+
+static bool
+set(struct cli *cli, const char *arg)
+{
+	const char *delim = strchr(arg, '=');
+	if (!delim) {
+		fprintf(stderr, "warn: --set expects PATH=VALUE\n");
+		return false;
+	}
+	char *path = g_strndup(arg, delim - arg);
+	const char *text = delim + 1;
+	enum backend backend;
+	bool integer = false;
+	bool ret = false;
+
+	const char *key = parse_path(path, &backend);
+	if (!key || !load(cli, backend)) {
+		goto out;
+	}
+	if (backend == BACKEND_GSETTINGS && !gsettings_check(cli, key, text, &integer)) {
+		goto out;
+	}
+	if (backend == BACKEND_XML) {
+		xpath_add_node((char *)key);
+	}
+
+	/* an empty value unsets environment variables and overrides, see apply_value() */
+	char *value = *text || backend == BACKEND_XML || backend == BACKEND_GSETTINGS
+		? g_strdup(text) : NULL;
+	char *snapshot = get_value(cli, backend, key);
+	if (apply_value(&cli->apply, backend, key, integer, &snapshot, value)
+			&& backend == BACKEND_GSETTINGS && !strcmp(key, "gtk-theme")) {
+		cli->gtk_theme_changed = true;
+	}
+	g_free(snapshot);
+	ret = true;
+out:
+	g_free(path);
+	return ret;
+}
+
+static bool
+list_themes(const char *kind)
+{
+	for (size_t i = 0; i < G_N_ELEMENTS(theme_kinds); i++) {
+		if (strcmp(kind, theme_kinds[i].kind)) {
+			continue;
+		}
+		struct themes themes = { 0 };
+		theme_find(&themes, theme_kinds[i].middle, theme_kinds[i].end);
+		for (int j = 0; j < themes.nr; j++) {
+			printf("%s\n", themes.data[j].name);
+		}
+		theme_free_vector(&themes);
+		return true;
+	}
+	fprintf(stderr, "warn: unknown kind of theme '%s'\n", kind);
+	return false;
+}
+
+/* all changes are saved in one go once every option has been handled */
+static bool
+save(struct cli *cli)
+{
+	bool *changed = cli->apply.changed;
+	bool ret = true;
+
+	if (changed[BACKEND_XML]) {
+		ret &= xml_save();
+	}
+	if (changed[BACKEND_GSETTINGS]) {
+		/* dconf writes asynchronously, so wait before exiting */
+		g_settings_sync();
+	}
+	if (changed[BACKEND_ENVIRONMENT]) {
+		ret &= environment_save();
+	}
+	if (changed[BACKEND_THEMERC_OVERRIDE]) {
+		ret &= kvfile_save(&cli->themerc_override);
+	}
+	return ret;
+}
+
+static bool
+run(const char *command, const char *arg)
+{
+	const char *argv[] = { command, arg, NULL };
+	GError *err = NULL;
+	GSubprocess *subprocess = g_subprocess_newv(argv, G_SUBPROCESS_FLAGS_NONE, &err);
+	if (subprocess) {
+		g_subprocess_wait_check(subprocess, NULL, &err);
+		g_object_unref(subprocess);
+	}
+	if (err) {
+		fprintf(stderr, "warn: %s: %s\n", command, err->message);
+		g_error_free(err);
+		return false;
+	}
+	return true;
+}
+
+static bool
+apply(struct cli *cli)
+{
+	/*
+	 * As in update(), the openbox theme called "GTK" follows the gtk theme.
+	 * Without GTK it cannot be generated in-process, so the script is used.
+	 */
+	if (cli->gtk_theme_changed && load(cli, BACKEND_XML)
+			&& !g_strcmp0(xml_get("/labwc_config/theme/name"), "GTK")
+			&& !run("labwc-gtktheme.py", NULL)) {
+		return false;
+	}
+	return reconfigure_labwc() || run("labwc", "-r");
+}
+
+static void
+cli_finish(struct cli *cli)
+{
+	if (cli->loaded[BACKEND_XML]) {
+		xml_finish();
+	}
+	if (cli->settings) {
+		g_object_unref(cli->settings);
+	}
+	environment_finish();
+	kvfile_finish(&cli->themerc_override);
+}
+
+int
+cli_run(int argc, char **argv)
+{
+	struct command *commands = g_new0(struct command, argc);
+	struct cli cli = { 0 };
+	int nr_commands = 0;
+	bool want_apply = false;
+	bool ok = true;
+
+	cli.apply.themerc_override = &cli.themerc_override;
+
+	/* check the whole command line before anything is read or written */
+	for (int i = 1; i < argc; i++) {
+		struct command *command = &commands[nr_commands];
+		int option = find_option(argv[i], &command->arg);
+		if (option < 0) {
+			fprintf(stderr, "warn: unknown option '%s'\n%s", argv[i], usage);
+			g_free(commands);
+			return EXIT_FAILURE;
+		}
+		if (options[option].has_arg && !command->arg) {
+			if (++i == argc) {
+				fprintf(stderr, "warn: %s needs an argument\n%s", argv[i - 1], usage);
+				g_free(commands);
+				return EXIT_FAILURE;
+			}
+			command->arg = argv[i];
+		}
+		command->option = option;
+		nr_commands++;
+	}
+
+	for (int i = 0; i < nr_commands; i++) {
+		switch (commands[i].option) {
+		case OPTION_GET:
+			ok &= get(&cli, commands[i].arg);
+			break;
+		case OPTION_SET:
+			ok &= set(&cli, commands[i].arg);
+			break;
+		case OPTION_LIST_THEMES:
+			ok &= list_themes(commands[i].arg);
+			break;
+		case OPTION_APPLY:
+			want_apply = true;
+			break;
+		case OPTION_NR:
+			break;
+		}
+	}
+
+	/* do not reconfigure labwc with half of the changes */
+	ok = save(&cli) && ok;
+	if (ok && want_apply) {
+		ok = apply(&cli);
+	}
+	fflush(stdout);
+
+	cli_finish(&cli);
+	g_free(commands);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
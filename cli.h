@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef CLI_H
+#define CLI_H
+#include <stdbool.h>
+
+/*
+ * Scripted use without a display. Settings are named by the file they live in:
+ *
+ *   /labwc_config/theme/name     node in ~/.config/labwc/rc.xml
+ *   environment/XCURSOR_THEME    variable in ~/.config/labwc/environment
+ *   themerc-override/border.width    key in ~/.config/labwc/themerc-override
+ *   gsettings/gtk-theme          key of org.gnome.desktop.interface
+ *
+ * and are read and written by the same code as the GUI's, so only values
+ * which change are written.
+ */
+
+/**
+ * cli_wanted - check if @argv asks for --get, --set, --list-themes or --apply
+ * If so, cli_run() handles the command line and GTK is never initialized.
+ */
+bool cli_wanted(int argc, char **argv);
+
+/**
+ * cli_run - run the options in @argv in order and return the exit status
+ * --get PATH        print the value, or exit with 1 if it is not set
+ * --set PATH=VALUE  set the value; an empty VALUE unsets environment
+ *                   variables and themerc overrides
+ * --list-themes KIND    print the names of the openbox, gtk, icon or cursor
+ *                   themes, one per line
+ * --apply           make labwc re-read its configuration
+ *
+ * Changes are saved once all options have been handled, and --apply is only
+ * acted on after that, wherever it appears.
+ */
+int cli_run(int argc, char **argv);
+
+#endif /* CLI_H */
@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <string.h>
+#include "css-preview.h"
+#include "gtktheme.h"
+#include "state.h"
+#include "theme-resource.h"
+#include "trace.h"
+#include "watchdog.h"
+
+/* Number of parsed themes to keep around for quickly flicking back and forth */
+#define CACHE_SIZE 4
+
+/*
+ * Preview widgets only. Like the generated "GTK" theme, they show the theme
+ * alone: neither the running theme nor ~/.config/gtk-3.0/gtk.css below it
+ * get through, see gtktheme.h.
+ */
+#define PREVIEW_PRIORITY GTKTHEME_PRIORITY
+
+struct entry {
+	char *key;
+	GtkCssProvider *provider;
+	GResource *resource; /* registered while the provider is cached, or NULL */
+};
+
+static struct {
+	GQueue entries; /* most recently used first */
+	GCancellable *cancellable;
+} cache;
+
+struct swap {
+	GtkStyleProvider *old;
+	GtkStyleProvider *new;
+	guint priority;
+};
+
+static void
+entry_free(struct entry *entry)
+{
+	g_free(entry->key);
+	g_object_unref(entry->provider);
+	if (entry->resource) {
+		g_resources_unregister(entry->resource);
+		g_resource_unref(entry->resource);
+	}
+	g_free(entry);
+}
+
+static GtkCssProvider *
+cache_lookup(const char *key)
+{
+	for (GList *link = cache.entries.head; link; link = link->next) {
+		struct entry *entry = link->data;
+		if (!strcmp(entry->key, key)) {
+			g_queue_unlink(&cache.entries, link);
+			g_queue_push_head_link(&cache.entries, link);
+			return entry->provider;
+		}
+	}
+	return NULL;
+}
+
+/* takes the registration of @resource, which may be NULL */
+static void
+cache_insert(const char *key, GtkCssProvider *provider, GResource *resource)
+{
+	struct entry *entry = g_new0(struct entry, 1);
+	entry->key = g_strdup(key);
+	entry->provider = g_object_ref(provider);
+	entry->resource = resource;
+	g_queue_push_head(&cache.entries, entry);
+	while (g_queue_get_length(&cache.entries) > CACHE_SIZE) {
+		entry_free(g_queue_pop_tail(&cache.entries));
+	}
+}
+
+static void
+swap_provider(GtkWidget *widget, gpointer data)
+{
+	struct swap *swap = data;
+	GtkStyleContext *context = gtk_widget_get_style_context(widget);
+	if (swap->old) {
+		gtk_style_context_remove_provider(context, swap->old);
+	}
+	if (swap->new) {
+		gtk_style_context_add_provider(context, swap->new, swap->priority);
+	}
+	if (GTK_IS_CONTAINER(widget)) {
+		gtk_container_forall(GTK_CONTAINER(widget), swap_provider, data);
+	}
+}
+
+/* style providers are not inherited, so add to every widget in the subtree */
+static void
+apply(GtkWidget *preview, GtkCssProvider *provider)
+{
+	struct swap swap = {
+		.old = g_object_get_data(G_OBJECT(preview), "provider"),
+		.new = GTK_STYLE_PROVIDER(provider),
+		.priority = PREVIEW_PRIORITY,
+	};
+	if (swap.old == swap.new) {
+		return;
+	}
+	swap_provider(preview, &swap);
+	g_object_set_data_full(G_OBJECT(preview), "provider",
+		g_object_ref(provider), g_object_unref);
+}
+
+/*
+ * GTK is not thread-safe, so only the reading is done on a worker thread.
+ * gtk.css usually just imports gtk-contained.css, so every stylesheet next
+ * to it is read, and parsing on the main thread then finds them all in the
+ * page cache. The provider is still loaded from the path rather than from
+ * data so that relative @import and url() references resolve. A gtk.gresource
+ * is loaded here too, but only registered on the main thread.
+ */
+static void
+read_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	const char *filename = task_data;
+	GError *err = NULL;
+	char *contents = NULL;
+
+	if (!g_file_get_contents(filename, &contents, NULL, &err)) {
+		g_task_return_error(task, err);
+		return;
+	}
+	g_free(contents);
+	GResource *resource = theme_resource_load(filename, &err);
+	if (err) {
+		g_task_return_error(task, err);
+		return;
+	}
+
+	char *dirname = g_path_get_dirname(filename);
+	GDir *dir = g_dir_open(dirname, 0, NULL);
+	const char *name;
+	while (dir && (name = g_dir_read_name(dir))
+			&& !g_cancellable_is_cancelled(cancellable)) {
+		if (!g_str_has_suffix(name, ".css")) {
+			continue;
+		}
+		char *path = g_build_filename(dirname, name, NULL);
+		if (g_file_get_contents(path, &contents, NULL, NULL)) {
+			g_free(contents);
+		}
+		g_free(path);
+	}
+	if (dir) {
+		g_dir_close(dir);
+	}
+	g_free(dirname);
+	g_task_return_pointer(task, resource, (GDestroyNotify)g_resource_unref);
+}
+
+static void
+read_done(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	const char *filename = g_task_get_task_data(G_TASK(result));
+	GError *err = NULL;
+
+	GResource *resource = g_task_propagate_pointer(G_TASK(result), &err);
+	if (err) {
+		if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			fprintf(stderr, "warn: cannot preview theme: %s\n", err->message);
+		}
+		g_error_free(err);
+		return;
+	}
+	if (resource) {
+		g_resources_register(resource);
+	}
+	/* parsing is the longest stretch left on the main thread */
+	GtkCssProvider *provider = gtk_css_provider_new();
+	gint64 start = trace_begin();
+	const char *previous = watchdog_begin("parsing gtk theme");
+	bool loaded = gtk_css_provider_load_from_path(provider, filename, &err);
+	watchdog_end(previous);
+	trace_end(start, "gtk_css_provider_load_from_path");
+	if (!loaded) {
+		fprintf(stderr, "warn: cannot preview theme: %s\n", err->message);
+		g_error_free(err);
+		g_object_unref(provider);
+		if (resource) {
+			g_resources_unregister(resource);
+			g_resource_unref(resource);
+		}
+		return;
+	}
+	cache_insert(filename, provider, resource);
+	apply(GTK_WIDGET(source_object), provider);
+	g_object_unref(provider);
+}
+
+void
+css_preview_set_theme(GtkWidget *preview, const char *name, const char *filename)
+{
+	if (cache.cancellable) {
+		g_cancellable_cancel(cache.cancellable);
+		g_clear_object(&cache.cancellable);
+	}
+	if (!name) {
+		return;
+	}
+
+	/* themes built into gtk (like Adwaita in some distros) have no file */
+	if (!filename) {
+		apply(preview, gtk_css_provider_get_named(name, NULL));
+		return;
+	}
+
+	GtkCssProvider *provider = cache_lookup(filename);
+	if (provider) {
+		apply(preview, provider);
+		return;
+	}
+
+	cache.cancellable = g_cancellable_new();
+	GTask *task = g_task_new(preview, cache.cancellable, read_done, NULL);
+	g_task_set_task_data(task, g_strdup(filename), g_free);
+	g_task_run_in_thread(task, read_thread);
+	g_object_unref(task);
+}
+
+GtkWidget *
+css_preview_new(void)
+{
+	GtkWidget *frame = gtk_frame_new(NULL);
+	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+	gtk_style_context_add_class(gtk_widget_get_style_context(vbox), "background");
+	gtk_container_add(GTK_CONTAINER(frame), vbox);
+
+	GtkWidget *headerbar = gtk_header_bar_new();
+	gtk_header_bar_set_title(GTK_HEADER_BAR(headerbar), _("Preview"));
+	gtk_box_pack_start(GTK_BOX(vbox), headerbar, FALSE, FALSE, 0);
+
+	GtkWidget *grid = gtk_grid_new();
+	g_object_set(grid, "margin", 10, "row-spacing", 6, "column-spacing", 6, NULL);
+	gtk_box_pack_start(GTK_BOX(vbox), grid, TRUE, TRUE, 0);
+
+	GtkWidget *widget = gtk_button_new_with_label(_("Button"));
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, 0, 1, 1);
+	widget = gtk_button_new_with_label(_("Suggested"));
+	gtk_style_context_add_class(gtk_widget_get_style_context(widget), "suggested-action");
+	gtk_grid_attach(GTK_GRID(grid), widget, 1, 0, 1, 1);
+	widget = gtk_check_button_new_with_label(_("Check"));
+	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(widget), TRUE);
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, 1, 1, 1);
+	widget = gtk_switch_new();
+	gtk_switch_set_active(GTK_SWITCH(widget), TRUE);
+	gtk_widget_set_halign(widget, GTK_ALIGN_START);
+	gtk_grid_attach(GTK_GRID(grid), widget, 1, 1, 1, 1);
+	widget = gtk_entry_new();
+	gtk_entry_set_text(GTK_ENTRY(widget), _("Text entry"));
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, 2, 2, 1);
+	widget = gtk_progress_bar_new();
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(widget), 0.6);
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, 3, 2, 1);
+
+	struct swap reset = {
+		.new = gtktheme_reset_provider(),
+		.priority = GTKTHEME_RESET_PRIORITY,
+	};
+	swap_provider(frame, &reset);
+	return frame;
+}
+
+void
+css_preview_finish(void)
+{
+	if (cache.cancellable) {
+		g_cancellable_cancel(cache.cancellable);
+		g_clear_object(&cache.cancellable);
+	}
+	g_queue_clear_full(&cache.entries, (GDestroyNotify)entry_free);
+}
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef CSS_PREVIEW_H
+#define CSS_PREVIEW_H
+#include <gtk/gtk.h>
+
+/**
+ * css_preview_new - create a panel of sample widgets for previewing gtk themes
+ */
+GtkWidget *css_preview_new(void);
+
+/**
+ * css_preview_set_theme - style the preview panel with a gtk theme
+ * @preview: widget returned by css_preview_new()
+ * @name: theme name, used for built-in themes when @filename is NULL
+ * @filename: path to <theme>/gtk-3.0/gtk.css
+ *
+ * The stylesheets are read on a worker thread and then parsed into a
+ * GtkCssProvider, which is only added to the style contexts of the preview
+ * subtree, so neither GSettings nor any other widget is touched. The most
+ * recently used providers are cached, along with the theme's gtk.gresource.
+ */
+void css_preview_set_theme(GtkWidget *preview, const char *name, const char *filename);
+
+void css_preview_finish(void);
+
+#endif /* CSS_PREVIEW_H */
@@ -1,127 +1,53 @@
 // SPDX-License-Identifier: GPL-2.0-only
-#define _POSIX_C_SOURCE 200809L
-#include <assert.h>
-#include <ctype.h>
-#include <dirent.h>
-#include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <strings.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include "theme.h"
+#include "environment.h"
+#include "kvfile.h"
 
-static void
-rtrim(char **s)
+static struct kvfile env;
+
+bool
+environment_init(const char *filename)
 {
-	size_t len = strlen(*s);
-	if (!len) {
-		return;
-	}
-	char *end = *s + len - 1;
-	while (end >= *s && isspace(*end)) {
-		end--;
-	}
-	*(end + 1) = '\0';
+	environment_finish();
+	return kvfile_init(&env, filename, '=');
 }
 
-static char *
-string_strip(char *s)
+void
+environment_init_from_data(const char *filename, const char *contents)
 {
-	rtrim(&s);
-	while (isspace(*s)) {
-		s++;
-	}
-	return s;
+	environment_finish();
+	kvfile_init_from_data(&env, filename, '=', contents);
 }
 
-static char *
-get_value(char *line, const char *key)
+bool
+environment_save(void)
 {
-	if (!line || !*line || line[0] == '#') {
-		return NULL;
-	}
-	char *p = strchr(line, '=');
-	if (!p) {
-		return NULL;
-	}
-	*p = '\0';
-	if (!!strcmp(key, string_strip(line))) {
-		return NULL;
-	}
-	char *value = string_strip(++p);
-	return value ? value : NULL;
+	return !env.filename || kvfile_save(&env);
 }
 
 void
-environment_get(char *buffer, size_t size, const char *key)
+environment_finish(void)
 {
-	char filename[4096];
-	snprintf(filename, sizeof(filename), "%s/%s", getenv("HOME"), ".config/labwc/environment");
-
-	char *value = NULL;
-	char *line = NULL;
-	size_t len = 0;
-	FILE *stream = fopen(filename, "r");
-	if (!stream) {
-		return;
-	}
+	kvfile_finish(&env);
+}
 
-	while (getline(&line, &len, stream) != -1) {
-		char *p = strrchr(line, '\n');
-		if (p) {
-			*p = '\0';
-		}
-		value = get_value(line, key);
-		if (value) {
-			snprintf(buffer, size, "%s", value);
-			break;
-		}
+void
+environment_get(char *buffer, size_t size, const char *key)
+{
+	const char *value = kvfile_get(&env, key);
+	if (value) {
+		snprintf(buffer, size, "%s", value);
 	}
-	free(line);
-	fclose(stream);
 }
 
 void
 environment_set(const char *key, const char *value)
 {
-	if (!key || !*key) {
-		return;
-	}
 	if (!value || !*value) {
 		return;
 	}
-
-	/* set cursor for labwc  - should cover 'replace' or 'append' */
-	char xcur[4096] = {0};
-	strcpy(xcur, key);
-	strcat(xcur, "=");
-	char filename[4096];
-	char bufname[4096];
-	char *home = getenv("HOME");
-	snprintf(filename, sizeof(filename), "%s/%s", home, ".config/labwc/environment");
-	snprintf(bufname, sizeof(bufname), "%s/%s", home, ".config/labwc/buf");
-	FILE *fe = fopen(filename, "r");
-	FILE *fw = fopen(bufname, "a");
-	if ((fe == NULL) || (fw == NULL)) {
-		perror("Unable to open file!");
-		return;
-	}
-	char chunk[128];
-	while (fgets(chunk, sizeof(chunk), fe) != NULL) {
-		if (strstr(chunk, xcur) != NULL) {
-			continue;
-		} else {
-			fprintf(fw, "%s", chunk);
-		}
-	}
-	fclose(fe);
-	if (value) {
-		fprintf(fw, "%s\n", strcat(xcur, value));
-	}
-	fclose(fw);
-	rename(bufname, filename);
+	kvfile_set(&env, key, value);
 }
 
 void
@@ -133,3 +59,8 @@ environment_set_num(const char *key, int value)
 	environment_set(key, buffer);
 }
 
+void
+environment_unset(const char *key)
+{
+	kvfile_unset(&env, key);
+}
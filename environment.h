@@ -1,11 +1,35 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
+#include <stdbool.h>
 #include <stdio.h>
 
+/**
+ * environment_init - read environment file into memory
+ * @filename: usually ~/.config/labwc/environment
+ *
+ * The file is held in a struct kvfile, so lines are kept in order including
+ * comments, and keys are looked up exactly through a hash table. Changes are
+ * only written by environment_save().
+ * Returns false if the file exists but cannot be read, see kvfile_init().
+ */
+bool environment_init(const char *filename);
+
+/* as environment_init() with @contents already read, NULL if missing */
+void environment_init_from_data(const char *filename, const char *contents);
+
+/**
+ * environment_save - write the file in one go if anything has changed
+ * The file is written to a temporary file which is renamed into place.
+ * Returns false on error
+ */
+bool environment_save(void);
+void environment_finish(void);
+
 void environment_get(char *buffer, size_t size, const char *key);
 
 void environment_set(const char *key, const char *value);
 void environment_set_num(const char *key, int value);
+void environment_unset(const char *key);
 
 #endif /* ENVIRONMENT_H */
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "gtktheme.h"
+#include "theme-resource.h"
+
+static GtkCssProvider *reset;
+
+GtkStyleProvider *
+gtktheme_reset_provider(void)
+{
+	if (!reset) {
+		reset = gtk_css_provider_new();
+		gtk_css_provider_load_from_data(reset, "* { all: unset; }", -1, NULL);
+	}
+	return GTK_STYLE_PROVIDER(reset);
+}
+
+void
+gtktheme_finish(void)
+{
+	g_clear_object(&reset);
+}
+
+/*
+ * Style contexts for a CSS node without a widget, as in gtk-demo's
+ * "Foreign drawing". @parent is NULL for a toplevel node.
+ */
+static GtkStyleContext *
+node_new(GtkStyleProvider *provider, GtkStyleContext *parent, const char *name,
+		const char *class, GtkStateFlags flags)
+{
+	GtkWidgetPath *path = parent
+		? gtk_widget_path_copy(gtk_style_context_get_path(parent))
+		: gtk_widget_path_new();
+	gtk_widget_path_append_type(path, G_TYPE_NONE);
+	gtk_widget_path_iter_set_object_name(path, -1, name);
+	if (class) {
+		gtk_widget_path_iter_add_class(path, -1, class);
+	}
+
+	GtkStyleContext *context = gtk_style_context_new();
+	gtk_style_context_set_path(context, path);
+	gtk_style_context_set_parent(context, parent);
+	gtk_style_context_set_state(context, flags);
+	gtk_style_context_add_provider(context, gtktheme_reset_provider(),
+		GTKTHEME_RESET_PRIORITY);
+	gtk_style_context_add_provider(context, provider, GTKTHEME_PRIORITY);
+	gtk_widget_path_unref(path);
+	return context;
+}
+
+static void
+append_color(GString *s, const char *key, const GdkRGBA *rgba)
+{
+	g_string_append_printf(s, "%s: #%02x%02x%02x\n", key, (int)(rgba->red * 255 + 0.5),
+		(int)(rgba->green * 255 + 0.5), (int)(rgba->blue * 255 + 0.5));
+}
+
+static void
+append_bg_color(GString *s, const char *key, GtkStyleContext *context)
+{
+	GdkRGBA *rgba;
+	gtk_style_context_get(context, gtk_style_context_get_state(context),
+		GTK_STYLE_PROPERTY_BACKGROUND_COLOR, &rgba, NULL);
+	append_color(s, key, rgba);
+	gdk_rgba_free(rgba);
+}
+
+static void
+append_fg_color(GString *s, const char *key, GtkStyleContext *context)
+{
+	GdkRGBA rgba;
+	gtk_style_context_get_color(context, gtk_style_context_get_state(context), &rgba);
+	append_color(s, key, &rgba);
+}
+
+static void
+generate(GString *s, GtkStyleProvider *provider)
+{
+	/* window.background.csd > headerbar.titlebar > label.title */
+	GtkStyleContext *window = node_new(provider, NULL, "window", "background", 0);
+	gtk_style_context_add_class(window, "csd");
+	GtkStyleContext *active = node_new(provider, window, "headerbar", "titlebar", 0);
+	GtkStyleContext *active_label = node_new(provider, active, "label", "title", 0);
+	GtkStyleContext *inactive = node_new(provider, window, "headerbar", "titlebar",
+		GTK_STATE_FLAG_BACKDROP);
+	GtkStyleContext *inactive_label = node_new(provider, inactive, "label", "title",
+		GTK_STATE_FLAG_BACKDROP);
+
+	/* window.background.popup > menu > menuitem > label */
+	GtkStyleContext *popup = node_new(provider, NULL, "window", "background", 0);
+	gtk_style_context_add_class(popup, "popup");
+	GtkStyleContext *menu = node_new(provider, popup, "menu", NULL, 0);
+	GtkStyleContext *item = node_new(provider, menu, "menuitem", NULL, 0);
+	GtkStyleContext *item_label = node_new(provider, item, "label", NULL, 0);
+	GtkStyleContext *hover = node_new(provider, menu, "menuitem", NULL, GTK_STATE_FLAG_PRELIGHT);
+	GtkStyleContext *hover_label = node_new(provider, hover, "label", NULL,
+		GTK_STATE_FLAG_PRELIGHT);
+
+	/* tooltip.background > label */
+	GtkStyleContext *tooltip = node_new(provider, NULL, "tooltip", "background", 0);
+	GtkStyleContext *tooltip_label = node_new(provider, tooltip, "label", NULL, 0);
+
+	g_string_append(s, "border.width: 1\n");
+	g_string_append(s, "padding.height: 4\n");
+	append_bg_color(s, "window.active.border.color", active);
+	append_bg_color(s, "window.inactive.border.color", inactive);
+	append_bg_color(s, "window.active.title.bg.color", active);
+	append_bg_color(s, "window.inactive.title.bg.color", inactive);
+	append_fg_color(s, "window.active.label.text.color", active_label);
+	append_fg_color(s, "window.inactive.label.text.color", inactive_label);
+	append_fg_color(s, "window.active.button.unpressed.image.color", active_label);
+	append_fg_color(s, "window.inactive.button.unpressed.image.color", inactive_label);
+	append_bg_color(s, "menu.items.bg.color", menu);
+	append_fg_color(s, "menu.items.text.color", item_label);
+	append_bg_color(s, "menu.items.active.bg.color", hover);
+	append_fg_color(s, "menu.items.active.text.color", hover_label);
+	append_bg_color(s, "osd.bg.color", tooltip);
+	append_fg_color(s, "osd.border.color", tooltip_label);
+	append_fg_color(s, "osd.label.text.color", tooltip_label);
+
+	GtkStyleContext *contexts[] = {
+		tooltip_label, tooltip, hover_label, hover, item_label, item, menu, popup,
+		inactive_label, inactive, active_label, active, window,
+	};
+	for (size_t i = 0; i < G_N_ELEMENTS(contexts); i++) {
+		g_object_unref(contexts[i]);
+	}
+}
+
+/* returns false if the first line of @themerc is not @stamp */
+static bool
+stamp_matches(const char *themerc, const char *stamp)
+{
+	char buf[4096];
+	FILE *fp = g_fopen(themerc, "r");
+	if (!fp) {
+		return false;
+	}
+	bool ret = fgets(buf, sizeof(buf), fp) && !strcmp(buf, stamp);
+	fclose(fp);
+	return ret;
+}
+
+bool
+gtktheme_generate(const char *name, const char *filename)
+{
+	if (!name) {
+		return false;
+	}
+
+	/* the stylesheets may be in gtk.gresource, which is updated on its own */
+	struct stat st = { 0 };
+	struct stat resource_st = { 0 };
+	if (filename && g_stat(filename, &st)) {
+		fprintf(stderr, "warn: cannot stat %s\n", filename);
+		return false;
+	}
+	if (filename) {
+		char *resource_filename = theme_resource_filename(filename);
+		g_stat(resource_filename, &resource_st);
+		g_free(resource_filename);
+	}
+	char *stamp = g_strdup_printf("# generated from gtk theme %s (%lld %lld)\n", name,
+		(long long)st.st_mtime, (long long)resource_st.st_mtime);
+	char *dir = g_build_filename(g_get_user_data_dir(), "themes", "GTK", "openbox-3", NULL);
+	char *themerc = g_build_filename(dir, "themerc", NULL);
+	GResource *resource = NULL;
+	bool ret = false;
+
+	if (stamp_matches(themerc, stamp)) {
+		ret = true;
+		goto out;
+	}
+
+	GtkCssProvider *provider;
+	if (filename) {
+		GError *err = NULL;
+		resource = theme_resource_load(filename, &err);
+		if (err) {
+			fprintf(stderr, "warn: %s\n", err->message);
+			g_error_free(err);
+			goto out;
+		}
+		if (resource) {
+			g_resources_register(resource);
+		}
+		provider = gtk_css_provider_new();
+		if (!gtk_css_provider_load_from_path(provider, filename, &err)) {
+			fprintf(stderr, "warn: %s\n", err->message);
+			g_error_free(err);
+			g_object_unref(provider);
+			goto out;
+		}
+	} else {
+		provider = gtk_css_provider_get_named(name, NULL);
+		if (!provider) {
+			fprintf(stderr, "warn: cannot find gtk theme %s\n", name);
+			goto out;
+		}
+		g_object_ref(provider);
+	}
+
+	GString *contents = g_string_new(stamp);
+	generate(contents, GTK_STYLE_PROVIDER(provider));
+	g_object_unref(provider);
+
+	GError *err = NULL;
+	if (g_mkdir_with_parents(dir, 0755)) {
+		fprintf(stderr, "warn: cannot create %s\n", dir);
+	} else if (!g_file_set_contents(themerc, contents->str, contents->len, &err)) {
+		fprintf(stderr, "warn: %s\n", err->message);
+		g_error_free(err);
+	} else {
+		ret = true;
+	}
+	g_string_free(contents, TRUE);
+out:
+	if (resource) {
+		g_resources_unregister(resource);
+		g_resource_unref(resource);
+	}
+	g_free(themerc);
+	g_free(dir);
+	g_free(stamp);
+	return ret;
+}
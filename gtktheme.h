@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef GTKTHEME_H
+#define GTKTHEME_H
+#include <gtk/gtk.h>
+#include <stdbool.h>
+
+/*
+ * Style contexts see the running theme and ~/.config/gtk-3.0/gtk.css too, so
+ * everything they set is unset above them, and the theme of interest goes
+ * above that again.
+ */
+#define GTKTHEME_RESET_PRIORITY (GTK_STYLE_PROVIDER_PRIORITY_USER + 1)
+#define GTKTHEME_PRIORITY (GTK_STYLE_PROVIDER_PRIORITY_USER + 2)
+
+/**
+ * gtktheme_reset_provider - style provider which unsets every property
+ * To be added at GTKTHEME_RESET_PRIORITY. The provider is owned by gtktheme.
+ */
+GtkStyleProvider *gtktheme_reset_provider(void);
+
+/**
+ * gtktheme_generate - write the labwc theme called "GTK" from a gtk theme
+ * @name: gtk theme name, used for built-in themes when @filename is NULL
+ * @filename: path to <theme>/gtk-3.0/gtk.css
+ *
+ * Colors of the headerbar, menus and tooltips are read from style contexts
+ * styled with the gtk theme, and written to
+ * ~/.local/share/themes/GTK/openbox-3/themerc as labwc-gtktheme.py does.
+ * A gtk.gresource next to @filename is registered while the theme is read.
+ * The first line of the themerc records the theme and the modification times
+ * of gtk.css and gtk.gresource, so nothing is done if they have not changed.
+ * Returns false on error
+ */
+bool gtktheme_generate(const char *name, const char *filename);
+
+void gtktheme_finish(void);
+
+#endif /* GTKTHEME_H */
@@ -1,61 +1,466 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "keyboard-layouts.h"
+#include "keyboard-layouts-builtin.h"
+#include "trace.h"
+
+/*
+ * Cache file layout:
+ *   struct cache_header
+ *   struct cache_entry[nr]           sorted by lang and variant
+ *   struct cache_item[nr_models]     sorted by name
+ *   struct cache_item[nr_options]    in the order of the rules list
+ *   char strings[]                   NUL-terminated strings referred to by offset
+ */
+#define CACHE_MAGIC "LTGKBL\0\0"
+#define CACHE_VERSION 4
+
+struct cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t nr;
+	uint32_t nr_models;
+	uint32_t nr_options;
+	uint64_t source_size;
+	int64_t source_mtime;
+	uint32_t source_path;
+	uint32_t strings_size;
+};
+
+struct cache_entry {
+	uint32_t lang;
+	uint32_t variant;
+	uint32_t description;
+};
+
+struct cache_item {
+	uint32_t name;
+	uint32_t description;
+};
 
 static int
 cmp_layouts(const void *a, const void *b)
 {
-	return strcmp(((struct layout *)a)->lang, ((struct layout *)b)->lang);
+	const struct layout *layout_a = a;
+	const struct layout *layout_b = b;
+	int ret = strcmp(layout_a->lang, layout_b->lang);
+	return ret ? ret : strcmp(layout_a->variant, layout_b->variant);
 }
 
-void
-keyboard_layouts_init(GList **layouts, const char *filename)
+static int
+cmp_items(const void *a, const void *b)
+{
+	return strcmp(((struct xkb_item *)a)->name, ((struct xkb_item *)b)->name);
+}
+
+static char *
+cache_filename(void)
+{
+	return g_build_filename(g_get_user_cache_dir(), "labwc-tweaks-gtk",
+		"keyboard-layouts.cache", NULL);
+}
+
+static struct xkb_item *
+load_items(const struct cache_item *cache_items, uint32_t nr, const char *strings,
+		uint32_t strings_size)
+{
+	if (!nr) {
+		return NULL;
+	}
+	struct xkb_item *items = g_new(struct xkb_item, nr);
+	for (uint32_t i = 0; i < nr; i++) {
+		if (cache_items[i].name >= strings_size
+				|| cache_items[i].description >= strings_size) {
+			g_free(items);
+			return NULL;
+		}
+		items[i].name = strings + cache_items[i].name;
+		items[i].description = strings + cache_items[i].description;
+	}
+	return items;
+}
+
+static bool
+load_cache(struct keyboard_layouts *layouts, const char *filename, const struct stat *st)
+{
+	char *path = cache_filename();
+	int fd = open(path, O_RDONLY);
+	g_free(path);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat cache_st;
+	if (fstat(fd, &cache_st) || (size_t)cache_st.st_size < sizeof(struct cache_header)) {
+		close(fd);
+		return false;
+	}
+	size_t size = cache_st.st_size;
+	void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+
+	const struct cache_header *header = map;
+	const struct cache_entry *entries = (const struct cache_entry *)(header + 1);
+	size_t max_entries = (size - sizeof(*header)) / sizeof(struct cache_item);
+	if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic))
+			|| header->version != CACHE_VERSION
+			|| header->source_size != (uint64_t)st->st_size
+			|| header->source_mtime != (int64_t)st->st_mtime
+			|| header->nr > max_entries
+			|| header->nr_models > max_entries
+			|| header->nr_options > max_entries) {
+		goto invalid;
+	}
+	size_t entries_size = header->nr * sizeof(struct cache_entry)
+		+ (header->nr_models + header->nr_options) * sizeof(struct cache_item);
+	if (entries_size > size - sizeof(*header) || !header->strings_size
+			|| header->strings_size != size - sizeof(*header) - entries_size) {
+		goto invalid;
+	}
+	const struct cache_item *models = (const struct cache_item *)(entries + header->nr);
+	const struct cache_item *options = models + header->nr_models;
+	const char *strings = (const char *)(options + header->nr_options);
+	uint32_t strings_size = header->strings_size;
+	if (strings[strings_size - 1] != '\0'
+			|| header->source_path >= strings_size
+			|| strcmp(strings + header->source_path, filename)) {
+		goto invalid;
+	}
+
+	layouts->data = g_new(struct layout, header->nr);
+	for (uint32_t i = 0; i < header->nr; i++) {
+		if (entries[i].lang >= strings_size
+				|| entries[i].variant >= strings_size
+				|| entries[i].description >= strings_size) {
+			goto invalid;
+		}
+		layouts->data[i].lang = strings + entries[i].lang;
+		layouts->data[i].variant = strings + entries[i].variant;
+		layouts->data[i].description = strings + entries[i].description;
+	}
+	layouts->nr = header->nr;
+	layouts->models = load_items(models, header->nr_models, strings, strings_size);
+	layouts->options = load_items(options, header->nr_options, strings, strings_size);
+	if ((header->nr_models && !layouts->models) || (header->nr_options && !layouts->options)) {
+		goto invalid;
+	}
+	layouts->nr_models = header->nr_models;
+	layouts->nr_options = header->nr_options;
+	layouts->map = map;
+	layouts->map_size = size;
+	return true;
+
+invalid:
+	g_clear_pointer(&layouts->data, g_free);
+	g_clear_pointer(&layouts->models, g_free);
+	g_clear_pointer(&layouts->options, g_free);
+	layouts->nr = 0;
+	munmap(map, size);
+	return false;
+}
+
+static uint32_t
+add_string(GByteArray *strings, const char *s)
+{
+	uint32_t offset = strings->len;
+	g_byte_array_append(strings, (const guint8 *)s, strlen(s) + 1);
+	return offset;
+}
+
+static struct cache_item *
+save_items(GByteArray *strings, struct xkb_item *items, int nr)
+{
+	struct cache_item *cache_items = g_new(struct cache_item, nr);
+	for (int i = 0; i < nr; i++) {
+		cache_items[i].name = add_string(strings, items[i].name);
+		cache_items[i].description = add_string(strings, items[i].description);
+	}
+	return cache_items;
+}
+
+static void
+save_cache(struct keyboard_layouts *layouts, const char *filename, const struct stat *st)
+{
+	GByteArray *strings = g_byte_array_new();
+	struct cache_entry *entries = g_new(struct cache_entry, layouts->nr);
+	for (int i = 0; i < layouts->nr; i++) {
+		entries[i].lang = add_string(strings, layouts->data[i].lang);
+		entries[i].variant = add_string(strings, layouts->data[i].variant);
+		entries[i].description = add_string(strings, layouts->data[i].description);
+	}
+	struct cache_item *models = save_items(strings, layouts->models, layouts->nr_models);
+	struct cache_item *options = save_items(strings, layouts->options, layouts->nr_options);
+
+	struct cache_header header = {
+		.magic = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.nr = layouts->nr,
+		.nr_models = layouts->nr_models,
+		.nr_options = layouts->nr_options,
+		.source_size = st->st_size,
+		.source_mtime = st->st_mtime,
+		.source_path = add_string(strings, filename),
+		.strings_size = strings->len,
+	};
+
+	GByteArray *buf = g_byte_array_sized_new(sizeof(header)
+		+ layouts->nr * sizeof(*entries)
+		+ (layouts->nr_models + layouts->nr_options) * sizeof(struct cache_item)
+		+ strings->len);
+	g_byte_array_append(buf, (const guint8 *)&header, sizeof(header));
+	g_byte_array_append(buf, (const guint8 *)entries, layouts->nr * sizeof(*entries));
+	g_byte_array_append(buf, (const guint8 *)models, layouts->nr_models * sizeof(*models));
+	g_byte_array_append(buf, (const guint8 *)options, layouts->nr_options * sizeof(*options));
+	g_byte_array_append(buf, strings->data, strings->len);
+
+	/* g_file_set_contents() renames into place, so readers never see partial files */
+	char *path = cache_filename();
+	char *dir = g_path_get_dirname(path);
+	if (g_mkdir_with_parents(dir, 0700) || !g_file_set_contents(path, (const char *)buf->data, buf->len, NULL)) {
+		fprintf(stderr, "warn: cannot write %s\n", path);
+	}
+	g_free(dir);
+	g_free(path);
+	g_byte_array_free(buf, TRUE);
+	g_byte_array_free(strings, TRUE);
+	g_free(options);
+	g_free(models);
+	g_free(entries);
+}
+
+static struct xkb_item *
+sort_items(GArray *array, int *nr)
 {
-	bool in_layout_section = false;
-	char *line = NULL;
-	size_t len = 0;
-	FILE *fp = fopen(filename, "r");
+	g_array_sort(array, cmp_items);
+	*nr = array->len;
+	return (struct xkb_item *)g_array_free(array, FALSE);
+}
+
+static struct xkb_item *
+free_items(GArray *array, int *nr)
+{
+	*nr = array->len;
+	return (struct xkb_item *)g_array_free(array, FALSE);
+}
 
-	if (!fp) {
-		perror("Error opening file");
-		exit(EXIT_FAILURE);
+/* parse all sections in a single pass and in place; the vectors point into layouts->buf */
+static bool
+parse(struct keyboard_layouts *layouts, const char *filename)
+{
+	if (!g_file_get_contents(filename, &layouts->buf, NULL, NULL)) {
+		return false;
 	}
-	while (getline(&line, &len, fp) != -1) {
-		char *p = strrchr(line, '\n');
-		if (p) {
-			*p = '\0';
+
+	GArray *array = g_array_new(FALSE, FALSE, sizeof(struct layout));
+	GArray *models = g_array_new(FALSE, FALSE, sizeof(struct xkb_item));
+	GArray *options = g_array_new(FALSE, FALSE, sizeof(struct xkb_item));
+	enum {
+		SECTION_OTHER,
+		SECTION_MODEL,
+		SECTION_LAYOUT,
+		SECTION_VARIANT,
+		SECTION_OPTION
+	} section = SECTION_OTHER;
+	char *next;
+	for (char *line = layouts->buf; line; line = next) {
+		next = strchr(line, '\n');
+		if (next) {
+			*next++ = '\0';
 		}
+		line = g_strstrip(line);
 		if (line[0] == '\0') {
 			continue;
 		} else if (line[0] == '!') {
-			in_layout_section = g_ascii_strncasecmp(line, "! layout", len) == 0;
-		} else if (in_layout_section) {
-			char **argv = g_strsplit(g_strstrip(line), " ", 2);
-			struct layout *layout = calloc(1, sizeof(*layout));
-			layout->lang = strdup(argv[0]);
-			layout->description = strdup(g_strstrip(argv[1]));
-			*layouts = g_list_append(*layouts, layout);
-			g_strfreev(argv);
+			if (!g_ascii_strcasecmp(line, "! model")) {
+				section = SECTION_MODEL;
+			} else if (!g_ascii_strcasecmp(line, "! layout")) {
+				section = SECTION_LAYOUT;
+			} else if (!g_ascii_strcasecmp(line, "! variant")) {
+				section = SECTION_VARIANT;
+			} else if (!g_ascii_strcasecmp(line, "! option")) {
+				section = SECTION_OPTION;
+			} else {
+				section = SECTION_OTHER;
+			}
+		} else if (section != SECTION_OTHER) {
+			/* "<name> <description>" or "<variant> <layout>: <description>" */
+			char *description = line + strcspn(line, " \t");
+			if (section == SECTION_OPTION && !memchr(line, ':', description - line)) {
+				/* group names may contain a space, as in "Compose key" */
+				char *gap = strstr(line, "  ");
+				if (gap) {
+					description = gap;
+				}
+			}
+			if (*description) {
+				*description++ = '\0';
+			}
+			description = g_strchug(description);
+			if (section == SECTION_MODEL || section == SECTION_OPTION) {
+				struct xkb_item item = { .name = line, .description = description };
+				g_array_append_val(section == SECTION_MODEL ? models : options, item);
+				continue;
+			}
+			struct layout layout = { .lang = line, .variant = "" };
+			if (section == SECTION_VARIANT) {
+				char *colon = strchr(description, ':');
+				if (!colon) {
+					continue;
+				}
+				*colon = '\0';
+				layout.lang = description;
+				layout.variant = line;
+				description = g_strchug(colon + 1);
+			}
+			layout.description = description;
+			g_array_append_val(array, layout);
 		}
 	}
-	free(line);
-	fclose(fp);
-	*layouts = g_list_sort(*layouts, (GCompareFunc)cmp_layouts);
+	qsort(array->data, array->len, sizeof(struct layout), cmp_layouts);
+	layouts->nr = array->len;
+	layouts->data = (struct layout *)g_array_free(array, FALSE);
+	layouts->models = sort_items(models, &layouts->nr_models);
+	layouts->options = free_items(options, &layouts->nr_options);
+	return true;
+}
+
+static void
+use_builtin(struct keyboard_layouts *layouts)
+{
+	layouts->data = (struct layout *)builtin_layouts;
+	layouts->nr = BUILTIN_LAYOUTS_NR;
+	layouts->models = (struct xkb_item *)builtin_models;
+	layouts->nr_models = BUILTIN_MODELS_NR;
+	layouts->options = (struct xkb_item *)builtin_options;
+	layouts->nr_options = BUILTIN_OPTIONS_NR;
+}
+
+static bool
+is_builtin_source(const struct stat *st)
+{
+	return BUILTIN_LAYOUTS_NR && st->st_size == BUILTIN_LAYOUTS_SOURCE_SIZE
+		&& st->st_mtime == BUILTIN_LAYOUTS_SOURCE_MTIME;
+}
+
+static void
+layouts_init(struct keyboard_layouts *layouts, const char *filename)
+{
+	struct stat st;
+
+	memset(layouts, 0, sizeof(*layouts));
+
+	/*
+	 * Use the table compiled in from the build host's rules list if the
+	 * file is identical or missing (as in minimal container images).
+	 */
+	if (stat(filename, &st)) {
+		fprintf(stderr, "warn: cannot stat %s; using built-in layouts\n", filename);
+		use_builtin(layouts);
+		return;
+	}
+	if (is_builtin_source(&st)) {
+		use_builtin(layouts);
+		return;
+	}
+	if (load_cache(layouts, filename, &st)) {
+		return;
+	}
+	if (!parse(layouts, filename)) {
+		fprintf(stderr, "warn: cannot read %s; using built-in layouts\n", filename);
+		use_builtin(layouts);
+		return;
+	}
+	save_cache(layouts, filename, &st);
+}
+
+void
+keyboard_layouts_init(struct keyboard_layouts *layouts, const char *filename)
+{
+	gint64 start = trace_begin();
+	layouts_init(layouts, filename);
+	trace_end(start, "keyboard_layouts_init");
 }
 
 void
-keyboard_layouts_finish(GList *layouts)
+keyboard_layouts_finish(struct keyboard_layouts *layouts)
+{
+	if (layouts->map) {
+		munmap(layouts->map, layouts->map_size);
+	}
+	g_free(layouts->buf);
+	if (layouts->data != builtin_layouts) {
+		g_free(layouts->data);
+	}
+	if (layouts->models != builtin_models) {
+		g_free(layouts->models);
+	}
+	if (layouts->options != builtin_options) {
+		g_free(layouts->options);
+	}
+	memset(layouts, 0, sizeof(*layouts));
+}
+
+int
+keyboard_layouts_find(struct keyboard_layouts *layouts, const char *lang, const char *variant)
+{
+	struct layout key = { .lang = lang, .variant = variant ? variant : "" };
+	if (!lang) {
+		return -1;
+	}
+	struct layout *layout = bsearch(&key, layouts->data, layouts->nr,
+		sizeof(struct layout), cmp_layouts);
+	return layout ? layout - layouts->data : -1;
+}
+
+struct layout *
+keyboard_layouts_find_variants(struct keyboard_layouts *layouts, const char *lang, int *nr)
 {
-	GList *iter;
-	for (iter = layouts; iter; iter = iter->next) {
-		struct layout *layout = (struct layout *)iter->data;
-		g_free(layout->lang);
-		g_free(layout->description);
-		g_free(layout);
+	*nr = 0;
+	int i = keyboard_layouts_find(layouts, lang, NULL);
+	if (i < 0) {
+		return NULL;
 	}
-	g_list_free(layouts);
+	/* variants sort directly after their layout because "" sorts first */
+	while (i + 1 + *nr < layouts->nr && !strcmp(layouts->data[i + 1 + *nr].lang, lang)) {
+		(*nr)++;
+	}
+	return *nr ? layouts->data + i + 1 : NULL;
+}
+
+static struct xkb_item *
+find_item(struct xkb_item *items, int nr, const char *name)
+{
+	struct xkb_item key = { .name = name };
+	if (!name) {
+		return NULL;
+	}
+	return bsearch(&key, items, nr, sizeof(struct xkb_item), cmp_items);
+}
+
+struct xkb_item *
+keyboard_layouts_find_model(struct keyboard_layouts *layouts, const char *name)
+{
+	return find_item(layouts->models, layouts->nr_models, name);
 }
 
+struct xkb_item *
+keyboard_layouts_find_option(struct keyboard_layouts *layouts, const char *name)
+{
+	for (int i = 0; name && i < layouts->nr_options; i++) {
+		if (!strcmp(layouts->options[i].name, name)) {
+			return layouts->options + i;
+		}
+	}
+	return NULL;
+}
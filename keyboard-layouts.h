@@ -3,12 +3,73 @@
 #define KEYBOARD_LAYOUTS_H
 #include <glib.h>
 
+/* a layout, or one of its variants if variant is not empty */
 struct layout {
-	char *lang;
-	char *description;
+	const char *lang;
+	const char *variant;
+	const char *description;
 };
 
-void keyboard_layouts_init(GList **layouts, const char *filename);
-void keyboard_layouts_finish(GList *layouts);
+/* a keyboard model, or an option or option group if name has no ':' */
+struct xkb_item {
+	const char *name;
+	const char *description;
+};
+
+/*
+ * All sections of an xkb rules list. Layouts are sorted by lang and then
+ * variant, so each layout is directly followed by its variants. Models are
+ * sorted by name. Options are kept in the order of the rules list, where each
+ * group is followed by its options, as group names do not always match the
+ * options' prefix ("Compose key" holds compose:*).
+ * Strings are owned by the vector.
+ */
+struct keyboard_layouts {
+	struct layout *data;
+	int nr;
+	struct xkb_item *models;
+	int nr_models;
+	struct xkb_item *options;
+	int nr_options;
+
+	/* backing store: either a mmap'd cache file or the parsed evdev.lst */
+	void *map;
+	size_t map_size;
+	char *buf;
+};
+
+/**
+ * keyboard_layouts_init - read models, layouts, variants and options of a rules list
+ * @layouts: vector to fill
+ * @filename: usually XKB_RULES_LIST, /usr/share/X11/xkb/rules/evdev.lst by default
+ *
+ * All sections are read in a single pass.
+ * If @filename is missing or identical to the build host's rules list, the
+ * table compiled in at build time is used. Otherwise the parsed result is kept
+ * in a binary cache in $XDG_CACHE_HOME which is validated against @filename's
+ * mtime and size and mmap'd read-only, so that subsequent runs need neither
+ * parsing nor per-entry allocations.
+ */
+void keyboard_layouts_init(struct keyboard_layouts *layouts, const char *filename);
+void keyboard_layouts_finish(struct keyboard_layouts *layouts);
+
+/**
+ * keyboard_layouts_find - binary search for a layout or variant
+ * @variant: NULL or "" for the layout itself
+ * Returns index into layouts->data or -1 if not found
+ */
+int keyboard_layouts_find(struct keyboard_layouts *layouts, const char *lang, const char *variant);
+
+/**
+ * keyboard_layouts_find_variants - get variants of a layout
+ * @nr: set to the number of variants
+ * Returns pointer to the first variant in layouts->data, or NULL if none
+ */
+struct layout *keyboard_layouts_find_variants(struct keyboard_layouts *layouts,
+	const char *lang, int *nr);
+
+/* search for a model or option by name; returns NULL if not found */
+struct xkb_item *keyboard_layouts_find_model(struct keyboard_layouts *layouts, const char *name);
+struct xkb_item *keyboard_layouts_find_option(struct keyboard_layouts *layouts, const char *name);
 
 #endif /* KEYBOARD_LAYOUTS_H */
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <pango/pangocairo.h>
+#include <stdio.h>
+#include <xkbcommon/xkbcommon.h>
+#include "keyboard-preview.h"
+
+#define KEY_SIZE 36
+#define KEY_GAP 3
+#define KEY_RADIUS 4
+#define ROW_UNITS 15
+#define EVDEV_OFFSET 8
+
+/* evdev keycode and width in quarter keys; keycode 0 is a gap */
+struct key {
+	int code;
+	int width;
+};
+
+static const struct key rows[][16] = {
+	{ {41, 4}, {2, 4}, {3, 4}, {4, 4}, {5, 4}, {6, 4}, {7, 4}, {8, 4}, {9, 4},
+		{10, 4}, {11, 4}, {12, 4}, {13, 4}, {14, 8} },
+	{ {15, 6}, {16, 4}, {17, 4}, {18, 4}, {19, 4}, {20, 4}, {21, 4}, {22, 4},
+		{23, 4}, {24, 4}, {25, 4}, {26, 4}, {27, 4}, {43, 6} },
+	{ {58, 7}, {30, 4}, {31, 4}, {32, 4}, {33, 4}, {34, 4}, {35, 4}, {36, 4},
+		{37, 4}, {38, 4}, {39, 4}, {40, 4}, {28, 9} },
+	{ {42, 5}, {86, 4}, {44, 4}, {45, 4}, {46, 4}, {47, 4}, {48, 4}, {49, 4},
+		{50, 4}, {51, 4}, {52, 4}, {53, 4}, {54, 11} },
+	{ {0, 15}, {57, 25}, {0, 20} },
+};
+
+#define NR_ROWS (int)(sizeof(rows) / sizeof(rows[0]))
+
+static struct {
+	GMutex lock;
+	GHashTable *keymaps;
+	GCancellable *cancellable;
+	char *shown; /* key of the keymap shown or being rendered; main thread only */
+} cache;
+
+struct request {
+	char *key;
+	struct xkb_rule_names names;
+};
+
+static void
+request_free(struct request *request)
+{
+	g_free(request->key);
+	g_free((char *)request->names.model);
+	g_free((char *)request->names.layout);
+	g_free((char *)request->names.variant);
+	g_free((char *)request->names.options);
+	g_free(request);
+}
+
+/* NULL for empty strings so that xkbcommon uses its defaults */
+static char *
+dup_name(const char *s)
+{
+	return s && *s ? g_strdup(s) : NULL;
+}
+
+static char *
+key_label(struct xkb_keymap *keymap, int code, xkb_level_index_t level)
+{
+	const xkb_keysym_t *syms;
+	char buf[16];
+
+	if (xkb_keymap_key_get_syms_by_level(keymap, code + EVDEV_OFFSET, 0, level, &syms) < 1) {
+		return NULL;
+	}
+	if (xkb_keysym_to_utf8(syms[0], buf, sizeof(buf)) <= 1
+			|| !g_unichar_isgraph(g_utf8_get_char(buf))) {
+		return NULL;
+	}
+	return g_strdup(buf);
+}
+
+static void
+draw_label(cairo_t *cr, PangoLayout *layout, const char *label, double x, double y)
+{
+	pango_layout_set_text(layout, label, -1);
+	cairo_move_to(cr, x, y);
+	pango_cairo_show_layout(cr, layout);
+}
+
+static void
+draw_key(cairo_t *cr, PangoLayout *layout, struct xkb_keymap *keymap, const struct key *key,
+		double x, double y)
+{
+	double w = key->width * KEY_SIZE / 4 - KEY_GAP;
+	double h = KEY_SIZE - KEY_GAP;
+
+	cairo_new_sub_path(cr);
+	cairo_arc(cr, x + w - KEY_RADIUS, y + KEY_RADIUS, KEY_RADIUS, -G_PI / 2, 0);
+	cairo_arc(cr, x + w - KEY_RADIUS, y + h - KEY_RADIUS, KEY_RADIUS, 0, G_PI / 2);
+	cairo_arc(cr, x + KEY_RADIUS, y + h - KEY_RADIUS, KEY_RADIUS, G_PI / 2, G_PI);
+	cairo_arc(cr, x + KEY_RADIUS, y + KEY_RADIUS, KEY_RADIUS, G_PI, 3 * G_PI / 2);
+	cairo_close_path(cr);
+	cairo_set_source_rgb(cr, 0.93, 0.93, 0.93);
+	cairo_fill_preserve(cr);
+	cairo_set_source_rgb(cr, 0.6, 0.6, 0.6);
+	cairo_stroke(cr);
+
+	/* shift level top left and base level bottom left, or just one letter */
+	char *base = key_label(keymap, key->code, 0);
+	char *shift = key_label(keymap, key->code, 1);
+	char *upper = base ? g_utf8_strup(base, -1) : NULL;
+	cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+	if (shift && !g_strcmp0(upper, shift)) {
+		draw_label(cr, layout, shift, x + 4, y + h / 2 - 2);
+	} else {
+		if (shift) {
+			draw_label(cr, layout, shift, x + 4, y + 1);
+		}
+		if (base) {
+			draw_label(cr, layout, base, x + 4, y + h / 2 - 2);
+		}
+	}
+	g_free(upper);
+	g_free(shift);
+	g_free(base);
+}
+
+static cairo_surface_t *
+render(struct xkb_keymap *keymap)
+{
+	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+		ROW_UNITS * KEY_SIZE + 1, NR_ROWS * KEY_SIZE + 1);
+	cairo_t *cr = cairo_create(surface);
+	cairo_set_line_width(cr, 1);
+	PangoLayout *layout = pango_cairo_create_layout(cr);
+	PangoFontDescription *font = pango_font_description_from_string("Sans 9");
+	pango_layout_set_font_description(layout, font);
+	pango_font_description_free(font);
+
+	for (int j = 0; j < NR_ROWS; j++) {
+		double x = 0.5;
+		for (const struct key *key = rows[j]; key->width; key++) {
+			if (key->code) {
+				draw_key(cr, layout, keymap, key, x, j * KEY_SIZE + 0.5);
+			}
+			x += key->width * KEY_SIZE / 4;
+		}
+	}
+
+	g_object_unref(layout);
+	cairo_destroy(cr);
+	return surface;
+}
+
+static void
+render_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	struct request *request = task_data;
+
+	/* keymap reference counts are not atomic, so only touch them under the lock */
+	g_mutex_lock(&cache.lock);
+	struct xkb_keymap *keymap = NULL;
+	if (cache.keymaps) {
+		keymap = g_hash_table_lookup(cache.keymaps, request->key);
+	}
+	if (keymap) {
+		xkb_keymap_ref(keymap);
+	}
+	g_mutex_unlock(&cache.lock);
+
+	if (!keymap) {
+		if (g_task_return_error_if_cancelled(task)) {
+			return;
+		}
+		struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_ENVIRONMENT_NAMES);
+		if (context) {
+			keymap = xkb_keymap_new_from_names(context, &request->names,
+				XKB_KEYMAP_COMPILE_NO_FLAGS);
+			xkb_context_unref(context);
+		}
+		if (!keymap) {
+			g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+				"cannot compile keymap %s", request->key);
+			return;
+		}
+		g_mutex_lock(&cache.lock);
+		if (cache.keymaps) {
+			g_hash_table_replace(cache.keymaps, g_strdup(request->key),
+				xkb_keymap_ref(keymap));
+		}
+		g_mutex_unlock(&cache.lock);
+	}
+
+	cairo_surface_t *surface = render(keymap);
+	g_mutex_lock(&cache.lock);
+	xkb_keymap_unref(keymap);
+	g_mutex_unlock(&cache.lock);
+	g_task_return_pointer(task, surface, (GDestroyNotify)cairo_surface_destroy);
+}
+
+static void
+render_done(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	GError *err = NULL;
+	cairo_surface_t *surface = g_task_propagate_pointer(G_TASK(result), &err);
+	if (err) {
+		if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			fprintf(stderr, "warn: %s\n", err->message);
+			gtk_image_clear(GTK_IMAGE(source_object));
+		}
+		g_error_free(err);
+		return;
+	}
+	gtk_image_set_from_surface(GTK_IMAGE(source_object), surface);
+	cairo_surface_destroy(surface);
+}
+
+void
+keyboard_preview_update(GtkWidget *image, const char *layout, const char *variant,
+		const char *model, const char *options)
+{
+	g_mutex_lock(&cache.lock);
+	if (!cache.keymaps) {
+		cache.keymaps = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, (GDestroyNotify)xkb_keymap_unref);
+	}
+	g_mutex_unlock(&cache.lock);
+
+	/* the rules are always evdev, so the key is the MLVO part of the tuple */
+	char *key = layout && *layout
+		? g_strdup_printf("%s:%s:%s:%s", model ? model : "", layout,
+			variant ? variant : "", options ? options : "")
+		: NULL;
+	if (!g_strcmp0(key, cache.shown)) {
+		g_free(key);
+		return;
+	}
+	g_free(cache.shown);
+	cache.shown = key;
+
+	if (cache.cancellable) {
+		g_cancellable_cancel(cache.cancellable);
+		g_clear_object(&cache.cancellable);
+	}
+	if (!key) {
+		gtk_image_clear(GTK_IMAGE(image));
+		return;
+	}
+
+	struct request *request = g_new0(struct request, 1);
+	request->names.rules = "evdev";
+	request->names.model = dup_name(model);
+	request->names.layout = dup_name(layout);
+	request->names.variant = dup_name(variant);
+	request->names.options = dup_name(options);
+	request->key = g_strdup(key);
+
+	cache.cancellable = g_cancellable_new();
+	GTask *task = g_task_new(image, cache.cancellable, render_done, NULL);
+	g_task_set_task_data(task, request, (GDestroyNotify)request_free);
+	g_task_run_in_thread(task, render_thread);
+	g_object_unref(task);
+}
+
+void
+keyboard_preview_finish(void)
+{
+	if (cache.cancellable) {
+		g_cancellable_cancel(cache.cancellable);
+		g_clear_object(&cache.cancellable);
+	}
+	g_clear_pointer(&cache.shown, g_free);
+	g_mutex_lock(&cache.lock);
+	g_clear_pointer(&cache.keymaps, g_hash_table_destroy);
+	g_mutex_unlock(&cache.lock);
+}
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef KEYBOARD_PREVIEW_H
+#define KEYBOARD_PREVIEW_H
+#include <gtk/gtk.h>
+
+/**
+ * keyboard_preview_update - show key legends of a keymap in @image
+ * @image: GtkImage to render into
+ * @layout: xkb layout, or NULL to clear the preview
+ * @variant, @model, @options: may be NULL or empty for defaults
+ *
+ * The keymap is compiled with libxkbcommon and rendered on a worker thread.
+ * Compiled keymaps are cached by their RMLVO names, and a newer request
+ * cancels any preview still in flight. Asking for the keymap which is already
+ * shown, or being rendered, does nothing.
+ */
+void keyboard_preview_update(GtkWidget *image, const char *layout, const char *variant,
+	const char *model, const char *options);
+
+void keyboard_preview_finish(void);
+
+#endif /* KEYBOARD_PREVIEW_H */
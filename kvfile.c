@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include "kvfile.h"
+
+struct line {
+	char *text;
+	char *key; /* NULL for comments, blank lines and anything else we do not understand */
+	char *value;
+};
+
+static void
+line_free(struct line *line)
+{
+	g_free(line->text);
+	g_free(line->key);
+	g_free(line->value);
+	g_free(line);
+}
+
+static bool
+is_comment(struct kvfile *kvfile, const char *s)
+{
+	/* themerc files are Xresources-like and may use '!' as well */
+	return *s == '#' || (kvfile->delimiter == ':' && *s == '!');
+}
+
+static struct line *
+line_new(struct kvfile *kvfile, const char *text)
+{
+	struct line *line = g_new0(struct line, 1);
+	line->text = g_strdup(text);
+
+	const char *p = text + strspn(text, " \t");
+	const char *delim = strchr(p, kvfile->delimiter);
+	if (is_comment(kvfile, p) || !delim) {
+		return line;
+	}
+	line->key = g_strstrip(g_strndup(p, delim - p));
+	line->value = g_strstrip(g_strdup(delim + 1));
+	if (!*line->key) {
+		g_clear_pointer(&line->key, g_free);
+		g_clear_pointer(&line->value, g_free);
+	}
+	return line;
+}
+
+static char *
+line_text(struct kvfile *kvfile, const char *key, const char *value)
+{
+	return kvfile->delimiter == ':'
+		? g_strdup_printf("%s: %s", key, value)
+		: g_strdup_printf("%s%c%s", key, kvfile->delimiter, value);
+}
+
+static void
+add_line(struct kvfile *kvfile, struct line *line)
+{
+	g_ptr_array_add(kvfile->lines, line);
+	if (line->key) {
+		g_hash_table_replace(kvfile->keys, line->key, line);
+	}
+}
+
+void
+kvfile_init_from_data(struct kvfile *kvfile, const char *filename, char delimiter,
+		const char *contents)
+{
+	memset(kvfile, 0, sizeof(*kvfile));
+	kvfile->filename = g_strdup(filename);
+	kvfile->delimiter = delimiter;
+	kvfile->lines = g_ptr_array_new_with_free_func((GDestroyNotify)line_free);
+	kvfile->keys = g_hash_table_new(g_str_hash, g_str_equal);
+
+	if (!contents) {
+		return;
+	}
+	char **lines = g_strsplit(contents, "\n", -1);
+	for (char **s = lines; *s; s++) {
+		/* no empty line after the final newline */
+		if (!s[1] && !**s) {
+			break;
+		}
+		add_line(kvfile, line_new(kvfile, *s));
+	}
+	g_strfreev(lines);
+}
+
+bool
+kvfile_init(struct kvfile *kvfile, const char *filename, char delimiter)
+{
+	char *contents = NULL;
+	GError *err = NULL;
+	bool ret = true;
+	if (!g_file_get_contents(filename, &contents, NULL, &err)) {
+		ret = g_error_matches(err, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+		if (!ret) {
+			fprintf(stderr, "warn: %s\n", err->message);
+		}
+		g_error_free(err);
+	}
+	kvfile_init_from_data(kvfile, filename, delimiter, contents);
+	g_free(contents);
+	return ret;
+}
+
+void
+kvfile_finish(struct kvfile *kvfile)
+{
+	if (kvfile->keys) {
+		g_hash_table_destroy(kvfile->keys);
+	}
+	if (kvfile->lines) {
+		g_ptr_array_free(kvfile->lines, TRUE);
+	}
+	g_free(kvfile->filename);
+	memset(kvfile, 0, sizeof(*kvfile));
+}
+
+bool
+kvfile_save(struct kvfile *kvfile)
+{
+	if (!kvfile->dirty) {
+		return true;
+	}
+	GString *contents = g_string_new(NULL);
+	for (guint i = 0; i < kvfile->lines->len; i++) {
+		struct line *line = g_ptr_array_index(kvfile->lines, i);
+		g_string_append(contents, line->text);
+		g_string_append_c(contents, '\n');
+	}
+
+	char *dir = g_path_get_dirname(kvfile->filename);
+	GError *err = NULL;
+	if (g_mkdir_with_parents(dir, 0755)) {
+		fprintf(stderr, "warn: cannot create %s\n", dir);
+	} else if (!g_file_set_contents(kvfile->filename, contents->str, contents->len, &err)) {
+		fprintf(stderr, "warn: %s\n", err->message);
+		g_error_free(err);
+	} else {
+		kvfile->dirty = false;
+	}
+	g_free(dir);
+	g_string_free(contents, TRUE);
+	return !kvfile->dirty;
+}
+
+const char *
+kvfile_get(struct kvfile *kvfile, const char *key)
+{
+	if (!key || !kvfile->keys) {
+		return NULL;
+	}
+	struct line *line = g_hash_table_lookup(kvfile->keys, key);
+	return line ? line->value : NULL;
+}
+
+void
+kvfile_set(struct kvfile *kvfile, const char *key, const char *value)
+{
+	if (!key || !*key || !value || !kvfile->lines) {
+		return;
+	}
+	struct line *line = g_hash_table_lookup(kvfile->keys, key);
+	if (line && !strcmp(line->value, value)) {
+		return;
+	}
+	kvfile->dirty = true;
+	char *text = line_text(kvfile, key, value);
+	if (!line) {
+		add_line(kvfile, line_new(kvfile, text));
+		g_free(text);
+		return;
+	}
+	g_free(line->text);
+	g_free(line->value);
+	line->text = text;
+	line->value = g_strdup(value);
+}
+
+void
+kvfile_unset(struct kvfile *kvfile, const char *key)
+{
+	if (!key || !kvfile->keys || !g_hash_table_remove(kvfile->keys, key)) {
+		return;
+	}
+
+	/* remove every assignment, not just the one in effect */
+	for (guint i = kvfile->lines->len; i > 0; i--) {
+		struct line *line = g_ptr_array_index(kvfile->lines, i - 1);
+		if (line->key && !strcmp(line->key, key)) {
+			g_ptr_array_remove_index(kvfile->lines, i - 1);
+		}
+	}
+	kvfile->dirty = true;
+}
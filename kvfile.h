@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef KVFILE_H
+#define KVFILE_H
+#include <glib.h>
+#include <stdbool.h>
+
+/*
+ * A file of "key=value" or "key: value" lines held in memory. Lines are kept
+ * in order and verbatim, including comments and anything which is not an
+ * assignment, and only lines which are changed are rewritten.
+ */
+struct kvfile {
+	char *filename;
+	char delimiter;
+	GPtrArray *lines;
+	GHashTable *keys; /* key -> line with the assignment in effect */
+	bool dirty;
+};
+
+/**
+ * kvfile_init - read file into memory
+ * @delimiter: '=' as in labwc's environment or ':' as in themerc
+ * A missing file is treated as empty and created by kvfile_save().
+ * Returns false if the file exists but cannot be read, in which case it is
+ * also treated as empty and must not be saved over.
+ */
+bool kvfile_init(struct kvfile *kvfile, const char *filename, char delimiter);
+
+/**
+ * kvfile_init_from_data - as kvfile_init() with contents already read
+ * @contents: nul-terminated contents of @filename, or NULL if it is missing
+ */
+void kvfile_init_from_data(struct kvfile *kvfile, const char *filename, char delimiter,
+	const char *contents);
+void kvfile_finish(struct kvfile *kvfile);
+
+/**
+ * kvfile_save - write the file in one go if anything has changed
+ * The file is written to a temporary file which is renamed into place.
+ * Returns false on error
+ */
+bool kvfile_save(struct kvfile *kvfile);
+
+/* exact, case-sensitive key lookup; returns NULL if not set */
+const char *kvfile_get(struct kvfile *kvfile, const char *key);
+
+/* change the assignment in effect in place, or append one */
+void kvfile_set(struct kvfile *kvfile, const char *key, const char *value);
+
+/* remove all assignments of @key */
+void kvfile_unset(struct kvfile *kvfile, const char *key);
+
+#endif /* KVFILE_H */
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <string.h>
+#include "keyboard-layouts.h"
+#include "layout-index.h"
+
+static int
+cmp_tokens(const void *a, const void *b)
+{
+	return strcmp(((struct layout_index_token *)a)->text,
+		((struct layout_index_token *)b)->text);
+}
+
+/* call @fn for each alphanumeric run in the case-folded @s */
+static void
+for_each_word(const char *s, void (*fn)(const char *word, gssize len, void *data), void *data)
+{
+	char *folded = g_utf8_casefold(s, -1);
+	const char *word = NULL;
+	for (const char *p = folded; ; p = g_utf8_next_char(p)) {
+		gboolean alnum = *p && g_unichar_isalnum(g_utf8_get_char(p));
+		if (alnum && !word) {
+			word = p;
+		} else if (!alnum && word) {
+			fn(word, p - word, data);
+			word = NULL;
+		}
+		if (!*p) {
+			break;
+		}
+	}
+	g_free(folded);
+}
+
+struct add_context {
+	struct layout_index *index;
+	GArray *tokens;
+	int layout;
+};
+
+static void
+add_word(const char *word, gssize len, void *data)
+{
+	struct add_context *context = data;
+	const char *text = g_string_chunk_insert_len(context->index->words, word, len);
+	for (const char *p = text; *p; p = g_utf8_next_char(p)) {
+		struct layout_index_token token = { .text = p, .layout = context->layout };
+		g_array_append_val(context->tokens, token);
+	}
+}
+
+void
+layout_index_init(struct layout_index *index, struct keyboard_layouts *layouts)
+{
+	struct add_context context = {
+		.index = index,
+		.tokens = g_array_new(FALSE, FALSE, sizeof(struct layout_index_token)),
+	};
+
+	index->words = g_string_chunk_new(16 * 1024);
+	for (int i = 0; i < layouts->nr; i++) {
+		struct layout *layout = layouts->data + i;
+		context.layout = i;
+		for_each_word(layout->lang, add_word, &context);
+		for_each_word(layout->variant, add_word, &context);
+		for_each_word(layout->description, add_word, &context);
+	}
+	g_array_sort(context.tokens, cmp_tokens);
+	index->nr = context.tokens->len;
+	index->tokens = (struct layout_index_token *)g_array_free(context.tokens, FALSE);
+	index->nr_layouts = layouts->nr;
+}
+
+void
+layout_index_finish(struct layout_index *index)
+{
+	g_free(index->tokens);
+	if (index->words) {
+		g_string_chunk_free(index->words);
+	}
+	memset(index, 0, sizeof(*index));
+}
+
+struct search_context {
+	struct layout_index *index;
+	gboolean *matches;
+	gboolean *hits;
+};
+
+static void
+search_word(const char *word, gssize len, void *data)
+{
+	struct search_context *context = data;
+	struct layout_index *index = context->index;
+	char *prefix = g_strndup(word, len);
+
+	/* lower bound of @prefix; all tokens starting with it follow */
+	int lo = 0;
+	int hi = index->nr;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (strcmp(index->tokens[mid].text, prefix) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	memset(context->hits, 0, index->nr_layouts * sizeof(gboolean));
+	for (int i = lo; i < index->nr && !strncmp(index->tokens[i].text, prefix, len); i++) {
+		context->hits[index->tokens[i].layout] = TRUE;
+	}
+	for (int i = 0; i < index->nr_layouts; i++) {
+		context->matches[i] = context->matches[i] && context->hits[i];
+	}
+	g_free(prefix);
+}
+
+int
+layout_index_search(struct layout_index *index, const char *query, gboolean *matches)
+{
+	struct search_context context = {
+		.index = index,
+		.matches = matches,
+		.hits = g_new(gboolean, index->nr_layouts),
+	};
+
+	for (int i = 0; i < index->nr_layouts; i++) {
+		matches[i] = TRUE;
+	}
+	if (query) {
+		for_each_word(query, search_word, &context);
+	}
+	g_free(context.hits);
+
+	int nr = 0;
+	for (int i = 0; i < index->nr_layouts; i++) {
+		nr += !!matches[i];
+	}
+	return nr;
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LAYOUT_INDEX_H
+#define LAYOUT_INDEX_H
+#include <glib.h>
+
+struct keyboard_layouts;
+
+struct layout_index_token {
+	const char *text;
+	int layout;
+};
+
+/*
+ * Sorted array of every suffix of every case-folded word in the layout codes,
+ * variant codes and descriptions. A prefix search over it is a substring search
+ * within words, done with one binary search and a linear scan of the matches.
+ */
+struct layout_index {
+	struct layout_index_token *tokens;
+	int nr;
+	int nr_layouts;
+	GStringChunk *words;
+};
+
+/**
+ * layout_index_init - build search index
+ * @layouts: must outlive the index; entries are referred to by position
+ */
+void layout_index_init(struct layout_index *index, struct keyboard_layouts *layouts);
+void layout_index_finish(struct layout_index *index);
+
+/**
+ * layout_index_search - find layouts matching all words in @query
+ * @matches: array of layouts->nr elements, set to TRUE for matching layouts
+ * Matching is case-insensitive and a query word may match any part of a word.
+ * An empty query matches everything.
+ * Returns the number of matches
+ */
+int layout_index_search(struct layout_index *index, const char *query, gboolean *matches);
+
+#endif /* LAYOUT_INDEX_H */
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "keyboard-layouts.h"
+#include "layout-index.h"
+#include "layout-selector.h"
+#include "state.h"
+
+enum {
+	COLUMN_CODE = 0,
+	COLUMN_DESCRIPTION,
+	COLUMN_LAYOUT,
+	COLUMN_NR
+};
+
+struct layout_selector {
+	struct keyboard_layouts *layouts;
+	struct layout_index index;
+	gboolean *matches;
+	GtkListStore *store;
+	GtkTreeModel *filter;
+	GtkWidget *view;
+	int active;
+	GArray *callbacks; /* of struct callback, run when active changes */
+};
+
+struct callback {
+	GCallback func;
+	gpointer data;
+};
+
+static void
+selector_free(struct layout_selector *selector)
+{
+	g_array_free(selector->callbacks, TRUE);
+	g_object_unref(selector->filter);
+	g_object_unref(selector->store);
+	layout_index_finish(&selector->index);
+	g_free(selector->matches);
+	g_free(selector);
+}
+
+static struct layout_selector *
+selector_from_widget(GtkWidget *widget)
+{
+	return g_object_get_data(G_OBJECT(widget), "layout-selector");
+}
+
+static gboolean
+is_visible(GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+	struct layout_selector *selector = data;
+	int i;
+	gtk_tree_model_get(model, iter, COLUMN_LAYOUT, &i, -1);
+	return selector->matches[i];
+}
+
+/* select and show the active row if the filter does not hide it */
+static void
+show_active(struct layout_selector *selector)
+{
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(selector->view));
+	if (selector->active < 0 || !selector->matches[selector->active]) {
+		gtk_tree_selection_unselect_all(selection);
+		return;
+	}
+	GtkTreePath *child_path = gtk_tree_path_new_from_indices(selector->active, -1);
+	GtkTreePath *path = gtk_tree_model_filter_convert_child_path_to_path(
+		GTK_TREE_MODEL_FILTER(selector->filter), child_path);
+	if (path) {
+		gtk_tree_selection_select_path(selection, path);
+		gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(selector->view), path, NULL, TRUE, 0.5, 0.0);
+		gtk_tree_path_free(path);
+	}
+	gtk_tree_path_free(child_path);
+}
+
+/*
+ * The tree selection changes with every refilter while typing in the search
+ * entry, so only a different layout is passed on
+ */
+static void
+set_active(struct layout_selector *selector, int active)
+{
+	if (active == selector->active) {
+		return;
+	}
+	selector->active = active;
+	for (guint i = 0; i < selector->callbacks->len; i++) {
+		struct callback *callback = &g_array_index(selector->callbacks, struct callback, i);
+		((void (*)(gpointer))callback->func)(callback->data);
+	}
+}
+
+static void
+selection_changed(GtkTreeSelection *selection, struct layout_selector *selector)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	int active;
+
+	/* rows hidden by the filter lose their selection, which is not a change */
+	if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+		gtk_tree_model_get(model, &iter, COLUMN_LAYOUT, &active, -1);
+		set_active(selector, active);
+	}
+}
+
+static void
+search_changed(GtkSearchEntry *entry, struct layout_selector *selector)
+{
+	layout_index_search(&selector->index, gtk_entry_get_text(GTK_ENTRY(entry)),
+		selector->matches);
+
+	/* detach while refiltering so the view does not process each row change */
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(selector->view));
+	g_signal_handlers_block_by_func(selection, selection_changed, selector);
+	gtk_tree_view_set_model(GTK_TREE_VIEW(selector->view), NULL);
+	gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(selector->filter));
+	gtk_tree_view_set_model(GTK_TREE_VIEW(selector->view), selector->filter);
+	g_signal_handlers_unblock_by_func(selection, selection_changed, selector);
+	show_active(selector);
+}
+
+GtkWidget *
+layout_selector_new(struct keyboard_layouts *layouts)
+{
+	struct layout_selector *selector = g_new0(struct layout_selector, 1);
+	selector->layouts = layouts;
+	selector->active = -1;
+	selector->callbacks = g_array_new(FALSE, FALSE, sizeof(struct callback));
+	layout_index_init(&selector->index, layouts);
+	selector->matches = g_new(gboolean, layouts->nr);
+	layout_index_search(&selector->index, NULL, selector->matches);
+
+	/* fill before attaching, as in theme_selector_new() */
+	selector->store = gtk_list_store_new(COLUMN_NR, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT);
+	for (int i = 0; i < layouts->nr; i++) {
+		struct layout *layout = layouts->data + i;
+		char *code = *layout->variant
+			? g_strdup_printf("%s(%s)", layout->lang, layout->variant)
+			: g_strdup(layout->lang);
+		gtk_list_store_insert_with_values(selector->store, NULL, -1,
+			COLUMN_CODE, code, COLUMN_DESCRIPTION, layout->description,
+			COLUMN_LAYOUT, i, -1);
+		g_free(code);
+	}
+	selector->filter = gtk_tree_model_filter_new(GTK_TREE_MODEL(selector->store), NULL);
+	gtk_tree_model_filter_set_visible_func(GTK_TREE_MODEL_FILTER(selector->filter),
+		is_visible, selector, NULL);
+
+	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+	GtkWidget *entry = gtk_search_entry_new();
+	gtk_entry_set_placeholder_text(GTK_ENTRY(entry), _("Search layouts"));
+	gtk_box_pack_start(GTK_BOX(vbox), entry, FALSE, FALSE, 0);
+
+	selector->view = gtk_tree_view_new_with_model(selector->filter);
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(selector->view), FALSE);
+	gtk_tree_view_set_search_column(GTK_TREE_VIEW(selector->view), COLUMN_DESCRIPTION);
+	gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(selector->view), -1, NULL,
+		gtk_cell_renderer_text_new(), "text", COLUMN_CODE, NULL);
+	gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(selector->view), -1, NULL,
+		gtk_cell_renderer_text_new(), "text", COLUMN_DESCRIPTION, NULL);
+
+	GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+		GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_scrolled_window_set_min_content_height(GTK_SCROLLED_WINDOW(scrolled), 200);
+	gtk_container_add(GTK_CONTAINER(scrolled), selector->view);
+	gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(selector->view));
+	gtk_tree_selection_set_mode(selection, GTK_SELECTION_SINGLE);
+	g_signal_connect(selection, "changed", G_CALLBACK(selection_changed), selector);
+	g_signal_connect(entry, "search-changed", G_CALLBACK(search_changed), selector);
+
+	g_object_set_data_full(G_OBJECT(vbox), "layout-selector", selector,
+		(GDestroyNotify)selector_free);
+	return vbox;
+}
+
+void
+layout_selector_set_active(GtkWidget *widget, const char *lang, const char *variant)
+{
+	struct layout_selector *selector = selector_from_widget(widget);
+	set_active(selector, keyboard_layouts_find(selector->layouts, lang, variant));
+	show_active(selector);
+}
+
+struct layout *
+layout_selector_get_active(GtkWidget *widget)
+{
+	struct layout_selector *selector = selector_from_widget(widget);
+	return selector->active < 0 ? NULL : selector->layouts->data + selector->active;
+}
+
+void
+layout_selector_connect_changed(GtkWidget *widget, GCallback callback, gpointer data)
+{
+	struct layout_selector *selector = selector_from_widget(widget);
+	struct callback c = { callback, data };
+	g_array_append_val(selector->callbacks, c);
+}
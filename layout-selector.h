@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LAYOUT_SELECTOR_H
+#define LAYOUT_SELECTOR_H
+#include <gtk/gtk.h>
+
+struct keyboard_layouts;
+
+/**
+ * layout_selector_new - create a searchable list of layouts and variants
+ * @layouts: must outlive the widget
+ *
+ * A GtkSearchEntry above a list which is filtered as you type using a
+ * layout_index built once when the widget is created.
+ */
+GtkWidget *layout_selector_new(struct keyboard_layouts *layouts);
+
+/**
+ * layout_selector_set_active - select layout and variant
+ * @variant: NULL or "" for the layout itself
+ */
+void layout_selector_set_active(GtkWidget *selector, const char *lang, const char *variant);
+
+/**
+ * layout_selector_get_active - get selected layout and variant
+ * The selection is kept when it is hidden by the search filter. Returns NULL
+ * if nothing is selected. Strings are owned by the layouts vector.
+ */
+struct layout *layout_selector_get_active(GtkWidget *selector);
+
+/**
+ * layout_selector_connect_changed - call @callback when another layout is selected
+ * @callback: void (*)(gpointer data)
+ * Searching, which hides and shows the selected row, does not count.
+ */
+void layout_selector_connect_changed(GtkWidget *selector, GCallback callback, gpointer data);
+
+#endif /* LAYOUT_SELECTOR_H */
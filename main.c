@@ -6,21 +6,242 @@
 #include <string.h>
 #include <strings.h>
 #include <sys/stat.h>
+#include "cli.h"
+#include "css-preview.h"
+#include "environment.h"
+#include "gtktheme.h"
 #include "state.h"
 #include "stack-appearance.h"
+#include "stack-behaviour.h"
 #include "stack-lang.h"
 #include "stack-mouse.h"
+#include "theme-preview.h"
+#include "trace.h"
 #include "update.h"
+#include "watchdog.h"
 #include "xml.h"
+#if HAVE_XKBCOMMON
+#include "keyboard-preview.h"
+#endif
+
+/*
+ * The files in ~/.config/labwc are read with async GIO so that the window
+ * stays responsive if $HOME is on a slow network filesystem. The pages are
+ * only built once all of them have been read.
+ */
+enum config_file {
+	CONFIG_RCXML = 0,
+	CONFIG_ENVIRONMENT,
+	CONFIG_THEMERC_OVERRIDE,
+	CONFIG_NR
+};
+
+static const char *config_names[CONFIG_NR] = {
+	[CONFIG_RCXML] = "rc.xml",
+	[CONFIG_ENVIRONMENT] = "environment",
+	[CONFIG_THEMERC_OVERRIDE] = "themerc-override",
+};
+
+static const enum backend config_backends[CONFIG_NR] = {
+	[CONFIG_RCXML] = BACKEND_XML,
+	[CONFIG_ENVIRONMENT] = BACKEND_ENVIRONMENT,
+	[CONFIG_THEMERC_OVERRIDE] = BACKEND_THEMERC_OVERRIDE,
+};
+
+struct load {
+	struct state *state;
+	GtkWidget *stack;
+	int pending;
+	GString *errors; /* names of the files which could not be read */
+	gint64 start;
+};
+
+struct load_file {
+	struct load *load;
+	enum config_file config_file;
+};
+
+/*
+ * Pages are only built when they are first shown, so that themes and keyboard
+ * layouts are not searched for unless they are needed. Until then, each page
+ * is an empty box which remembers how to build itself.
+ */
+struct page {
+	struct state *state;
+	const char *name;
+	void (*init)(struct state *state, GtkWidget *vbox);
+};
+
+/* from main() until the first page is shown */
+static gint64 startup;
+
+static void
+page_build(GtkWidget *vbox)
+{
+	struct page *page = g_object_get_data(G_OBJECT(vbox), "page");
+	if (!page) {
+		return;
+	}
+	char trace_name[64];
+	snprintf(trace_name, sizeof(trace_name), "page %s", page->name);
+	gint64 start = trace_begin();
+	const char *previous = watchdog_begin("building page");
+	page->init(page->state, vbox);
+	update_add_widgets(page->state);
+	gtk_widget_show_all(vbox);
+	watchdog_end(previous);
+	trace_end(start, trace_name);
+	g_object_set_data(G_OBJECT(vbox), "page", NULL);
+}
+
+static void
+page_add(struct state *state, GtkWidget *stack, const char *name, const char *title,
+		void (*init)(struct state *state, GtkWidget *vbox))
+{
+	struct page *page = g_new0(struct page, 1);
+	page->state = state;
+	page->name = name;
+	page->init = init;
+
+	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	g_object_set_data_full(G_OBJECT(vbox), "page", page, g_free);
+	gtk_stack_add_named(GTK_STACK(stack), vbox, name);
+	gtk_container_child_set(GTK_CONTAINER(stack), vbox, "title", title, NULL);
+	gtk_widget_show(vbox);
+}
+
+static void
+visible_page_changed(GtkWidget *stack, GParamSpec *pspec, gpointer data)
+{
+	GtkWidget *vbox = gtk_stack_get_visible_child(GTK_STACK(stack));
+	if (vbox) {
+		page_build(vbox);
+	}
+}
+
+static void
+build_pages(struct state *state, GtkWidget *stack, GString *errors)
+{
+	update_init(state);
+	page_add(state, stack, "appearance", _("Appearance"), stack_appearance_init);
+	page_add(state, stack, "behaviour", _("Behaviour"), stack_behaviour_init);
+	page_add(state, stack, "mouse", _("Mouse & Touchpad"), stack_mouse_init);
+	page_add(state, stack, "lang", _("Language & Region"), stack_lang_init);
+	g_signal_connect(stack, "notify::visible-child", G_CALLBACK(visible_page_changed), NULL);
+	visible_page_changed(stack, NULL, NULL);
+	trace_end(startup, "startup");
+
+	gtk_spinner_stop(GTK_SPINNER(state->widgets.update_spinner));
+	if (errors) {
+		char *text = g_strdup_printf(_("Error: cannot read %s"), errors->str);
+		gtk_label_set_text(GTK_LABEL(state->widgets.update_status), text);
+		g_free(text);
+	} else {
+		gtk_label_set_text(GTK_LABEL(state->widgets.update_status), "");
+	}
+	gtk_widget_set_sensitive(state->widgets.update_button, TRUE);
+	gtk_widget_set_sensitive(state->widgets.auto_apply, TRUE);
+}
+
+static void
+config_loaded(GObject *source, GAsyncResult *res, gpointer data)
+{
+	struct load_file *load_file = data;
+	struct load *load = load_file->load;
+	struct state *state = load->state;
+	char *filename = g_file_get_path(G_FILE(source));
+	char *contents = NULL;
+	gsize length = 0;
+	GError *err = NULL;
+	char trace_name[64];
+
+	snprintf(trace_name, sizeof(trace_name), "load %s", config_names[load_file->config_file]);
+	trace_end(load->start, trace_name);
+	if (!g_file_load_contents_finish(G_FILE(source), res, &contents, &length, NULL, &err)) {
+		/*
+		 * Pages are still built from an empty file, but one which exists
+		 * is never overwritten with just the settings shown on them
+		 */
+		if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+			fprintf(stderr, "warn: %s\n", err->message);
+			state->unreadable[config_backends[load_file->config_file]] = true;
+			if (!load->errors) {
+				load->errors = g_string_new(config_names[load_file->config_file]);
+			} else {
+				g_string_append_printf(load->errors, ", %s",
+					config_names[load_file->config_file]);
+			}
+		}
+		g_error_free(err);
+	}
+
+	/* the contents are nul-terminated; NULL means the file is created on save */
+	switch (load_file->config_file) {
+	case CONFIG_RCXML: {
+		gint64 start = trace_begin();
+		const char *previous = watchdog_begin("parsing rc.xml");
+		xml_init_from_data(filename, contents, (int)length);
+		trace_end(start, "xml_init_from_data");
+		start = trace_begin();
+		xml_setup_nodes();
+		trace_end(start, "xml_setup_nodes");
+		watchdog_end(previous);
+		break;
+	}
+	case CONFIG_ENVIRONMENT:
+		environment_init_from_data(filename, contents);
+		break;
+	case CONFIG_THEMERC_OVERRIDE:
+		kvfile_init_from_data(&state->themerc_override, filename, ':', contents);
+		break;
+	case CONFIG_NR:
+		break;
+	}
+	g_free(contents);
+	g_free(filename);
+	g_free(load_file);
+
+	if (!--load->pending) {
+		build_pages(state, load->stack, load->errors);
+		if (load->errors) {
+			g_string_free(load->errors, TRUE);
+		}
+		g_free(load);
+	}
+}
+
+static void
+config_load(struct state *state, GtkWidget *stack)
+{
+	struct load *load = g_new0(struct load, 1);
+	load->state = state;
+	load->stack = stack;
+	load->pending = CONFIG_NR;
+	load->start = trace_begin();
+
+	for (int i = 0; i < CONFIG_NR; i++) {
+		struct load_file *load_file = g_new0(struct load_file, 1);
+		load_file->load = load;
+		load_file->config_file = i;
+		char *filename = g_build_filename(g_get_home_dir(), ".config", "labwc",
+			config_names[i], NULL);
+		GFile *file = g_file_new_for_path(filename);
+		g_file_load_contents_async(file, NULL, config_loaded, load_file);
+		g_object_unref(file);
+		g_free(filename);
+	}
+}
 
 static void
 activate(GtkApplication *app, gpointer user_data)
 {
 	struct state *state = (struct state *)user_data;
+	gint64 start = trace_begin();
 
 	/* window */
 	state->window = gtk_application_window_new(app);
 	gtk_window_set_title(GTK_WINDOW(state->window), "Tweaks GTK");
+	g_signal_connect(state->window, "destroy", G_CALLBACK(gtk_widget_destroyed), &state->window);
 
 	/* grid */
 	GtkWidget *grid = gtk_grid_new();
@@ -28,30 +249,62 @@ activate(GtkApplication *app, gpointer user_data)
 	GtkWidget *sidebar = gtk_stack_sidebar_new();
 	GtkWidget *separator = gtk_separator_new(GTK_ORIENTATION_VERTICAL);
 	GtkWidget *stack = gtk_stack_new();
+	GtkWidget *bottom = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
 	GtkWidget *bottom_buttons = gtk_button_box_new(GTK_ORIENTATION_HORIZONTAL);
 	gtk_grid_set_row_spacing(GTK_GRID(grid), 10);
 	gtk_grid_attach(GTK_GRID(grid), sidebar, 0, 0, 1, 2);
 	gtk_grid_attach(GTK_GRID(grid), separator, 1, 0, 1, 2);
 	gtk_grid_attach(GTK_GRID(grid), stack, 2, 0, 1, 1);
-	gtk_grid_attach(GTK_GRID(grid), bottom_buttons, 0, 1, 3, 1);
+	gtk_grid_attach(GTK_GRID(grid), bottom, 0, 1, 3, 1);
 
 	/* sidebar + stack */
 	gtk_stack_sidebar_set_stack(GTK_STACK_SIDEBAR(sidebar), GTK_STACK(stack));
-	stack_appearance_init(state, stack);
-	stack_mouse_init(state, stack);
-	stack_lang_init(state, stack);
+
+	/* progress and errors of update() */
+	state->widgets.update_spinner = gtk_spinner_new();
+	state->widgets.update_status = gtk_label_new(NULL);
+	gtk_label_set_ellipsize(GTK_LABEL(state->widgets.update_status), PANGO_ELLIPSIZE_END);
+	gtk_widget_set_halign(state->widgets.update_status, GTK_ALIGN_START);
+	gtk_box_pack_start(GTK_BOX(bottom), state->widgets.update_spinner, FALSE, FALSE, 6);
+	gtk_box_pack_start(GTK_BOX(bottom), state->widgets.update_status, TRUE, TRUE, 0);
+	gtk_box_pack_end(GTK_BOX(bottom), bottom_buttons, FALSE, FALSE, 0);
+	state->widgets.auto_apply = gtk_check_button_new_with_label(_("Apply automatically"));
+	gtk_box_pack_end(GTK_BOX(bottom), state->widgets.auto_apply, FALSE, FALSE, 6);
 
 	/* bottom buttons */
 	GtkWidget *button = gtk_button_new_with_label(_("Update"));
 	g_signal_connect(button, "clicked", G_CALLBACK(update), state);
 	gtk_container_add(GTK_CONTAINER(bottom_buttons), button);
+	state->widgets.update_button = button;
 	button = gtk_button_new_with_label(_("Quit"));
 	g_signal_connect_swapped(button, "clicked", G_CALLBACK(gtk_widget_destroy), state->window);
 	gtk_container_add(GTK_CONTAINER(bottom_buttons), button);
 	gtk_button_box_set_layout(GTK_BUTTON_BOX(bottom_buttons), GTK_BUTTONBOX_END);
 
-	/* show */
+	/* show, and build the pages once the config files have been read */
+	gtk_widget_set_sensitive(state->widgets.update_button, FALSE);
+	gtk_widget_set_sensitive(state->widgets.auto_apply, FALSE);
+	gtk_label_set_text(GTK_LABEL(state->widgets.update_status), _("Loading..."));
+	gtk_spinner_start(GTK_SPINNER(state->widgets.update_spinner));
 	gtk_widget_show_all(state->window);
+	trace_end(start, "activate");
+	config_load(state, stack);
+}
+
+static gint
+handle_local_options(GApplication *app, GVariantDict *options, gpointer user_data)
+{
+	struct state *state = (struct state *)user_data;
+	gint debounce_ms;
+
+	if (g_variant_dict_lookup(options, "debounce-ms", "i", &debounce_ms)) {
+		if (debounce_ms < 0) {
+			fprintf(stderr, "warn: ignoring negative --debounce-ms\n");
+		} else {
+			state->debounce_ms = debounce_ms;
+		}
+	}
+	return -1;
 }
 
 int
@@ -62,29 +315,54 @@ main(int argc, char **argv)
 	bindtextdomain(GETTEXT_PACKAGE, LOCALEDIR);
 	textdomain(GETTEXT_PACKAGE);
 #endif
-	struct state state = { 0 };
 
-	/* read/create config file */
-	char filename[4096];
-	char *home = getenv("HOME");
-	snprintf(filename, sizeof(filename), "%s/%s", home, ".config/labwc/rc.xml");
-	xml_init(filename);
-	xml_setup_nodes();
+	/* --get, --set, --list-themes and --apply are handled without a display */
+	if (cli_wanted(argc, argv)) {
+		return cli_run(argc, argv);
+	}
+
+	trace_init();
+	startup = trace_begin();
+	watchdog_init(0);
+	struct state state = { 0 };
+	state.debounce_ms = 500;
 
 	/* connect to gsettings */
+	gint64 start = trace_begin();
 	state.settings = g_settings_new("org.gnome.desktop.interface");
+	trace_end(start, "g_settings_new");
+
+	/*
+	 * Hold back changes until update() calls g_settings_apply() so that they
+	 * are written as one dconf transaction and GTK clients restyle only once
+	 */
+	g_settings_delay(state.settings);
 
 	/* start ui */
 	GtkApplication *app;
 	int status;
 	app = gtk_application_new(NULL, G_APPLICATION_DEFAULT_FLAGS);
+	g_application_add_main_option(G_APPLICATION(app), "debounce-ms", 0, 0, G_OPTION_ARG_INT,
+		_("Milliseconds without changes before applying automatically"), "MS");
+	g_signal_connect(app, "handle-local-options", G_CALLBACK(handle_local_options), &state);
 	g_signal_connect(app, "activate", G_CALLBACK(activate), &state);
 	status = g_application_run(G_APPLICATION(app), argc, argv);
 	g_object_unref(app);
 
 	/* clean up */
+	css_preview_finish();
+	gtktheme_finish();
+	theme_preview_finish();
+#if HAVE_XKBCOMMON
+	keyboard_preview_finish();
+#endif
 	xml_finish();
+	environment_finish();
+	kvfile_finish(&state.themerc_override);
+	update_finish(&state);
 	pango_cairo_font_map_set_default(NULL);
+	watchdog_finish();
+	trace_finish();
 
 	return status;
 }
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <string.h>
+#include "keyboard-layouts.h"
+#include "option-selector.h"
+
+enum {
+	COLUMN_NAME = 0,
+	COLUMN_DESCRIPTION,
+	COLUMN_ACTIVE,
+	COLUMN_IS_OPTION,
+	COLUMN_NR
+};
+
+struct option_selector {
+	GtkTreeStore *store;
+	GtkWidget *view;
+	GHashTable *rows; /* name -> GtkTreeIter */
+
+	/* active options which are not in the rules list, kept so they are not lost */
+	GPtrArray *unknown;
+};
+
+static void
+selector_free(struct option_selector *selector)
+{
+	g_ptr_array_free(selector->unknown, TRUE);
+	g_hash_table_destroy(selector->rows);
+	g_object_unref(selector->store);
+	g_free(selector);
+}
+
+static struct option_selector *
+selector_from_widget(GtkWidget *widget)
+{
+	return g_object_get_data(G_OBJECT(widget), "option-selector");
+}
+
+static GtkTreeIter *
+add_row(struct option_selector *selector, GtkTreeIter *parent, const char *name,
+		const char *description, gboolean is_option)
+{
+	GtkTreeIter iter;
+	gtk_tree_store_insert_with_values(selector->store, &iter, parent, -1,
+		COLUMN_NAME, name, COLUMN_DESCRIPTION, description,
+		COLUMN_ACTIVE, FALSE, COLUMN_IS_OPTION, is_option, -1);
+	GtkTreeIter *copy = gtk_tree_iter_copy(&iter);
+	g_hash_table_insert(selector->rows, g_strdup(name), copy);
+	return copy;
+}
+
+static void
+toggled(GtkCellRendererToggle *renderer, char *path, struct option_selector *selector)
+{
+	GtkTreeIter iter;
+	gboolean active;
+	GtkTreeModel *model = GTK_TREE_MODEL(selector->store);
+	if (!gtk_tree_model_get_iter_from_string(model, &iter, path)) {
+		return;
+	}
+	gtk_tree_model_get(model, &iter, COLUMN_ACTIVE, &active, -1);
+	gtk_tree_store_set(selector->store, &iter, COLUMN_ACTIVE, !active, -1);
+}
+
+GtkWidget *
+option_selector_new(struct keyboard_layouts *layouts)
+{
+	struct option_selector *selector = g_new0(struct option_selector, 1);
+	selector->store = gtk_tree_store_new(COLUMN_NR, G_TYPE_STRING, G_TYPE_STRING,
+		G_TYPE_BOOLEAN, G_TYPE_BOOLEAN);
+	selector->rows = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify)gtk_tree_iter_free);
+	selector->unknown = g_ptr_array_new_with_free_func(g_free);
+
+	/*
+	 * Options are in the order of the rules list, where each group line is
+	 * followed by its options. The group's name is not always their prefix,
+	 * as "Compose key" holds compose:*, so options go under the preceding
+	 * group. Any before the first group are kept as unknown if active.
+	 */
+	GtkTreeIter *parent = NULL;
+	for (int i = 0; i < layouts->nr_options; i++) {
+		struct xkb_item *item = layouts->options + i;
+		if (!strchr(item->name, ':')) {
+			parent = g_hash_table_lookup(selector->rows, item->name);
+			if (!parent) {
+				parent = add_row(selector, NULL, item->name, item->description, FALSE);
+			}
+		} else if (parent && !g_hash_table_contains(selector->rows, item->name)) {
+			add_row(selector, parent, item->name, item->description, TRUE);
+		}
+	}
+
+	selector->view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(selector->store));
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(selector->view), FALSE);
+	gtk_tree_view_set_search_column(GTK_TREE_VIEW(selector->view), COLUMN_DESCRIPTION);
+
+	GtkCellRenderer *renderer = gtk_cell_renderer_toggle_new();
+	g_signal_connect(renderer, "toggled", G_CALLBACK(toggled), selector);
+	GtkTreeViewColumn *column = gtk_tree_view_column_new();
+	gtk_tree_view_column_pack_start(column, renderer, FALSE);
+	gtk_tree_view_column_set_attributes(column, renderer, "active", COLUMN_ACTIVE,
+		"visible", COLUMN_IS_OPTION, NULL);
+	renderer = gtk_cell_renderer_text_new();
+	gtk_tree_view_column_pack_start(column, renderer, TRUE);
+	gtk_tree_view_column_set_attributes(column, renderer, "text", COLUMN_DESCRIPTION, NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(selector->view), column);
+	gtk_tree_view_set_tooltip_column(GTK_TREE_VIEW(selector->view), COLUMN_NAME);
+
+	GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+		GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_scrolled_window_set_min_content_height(GTK_SCROLLED_WINDOW(scrolled), 200);
+	gtk_container_add(GTK_CONTAINER(scrolled), selector->view);
+
+	g_object_set_data_full(G_OBJECT(scrolled), "option-selector", selector,
+		(GDestroyNotify)selector_free);
+	return scrolled;
+}
+
+void
+option_selector_set_active(GtkWidget *widget, const char *options)
+{
+	struct option_selector *selector = selector_from_widget(widget);
+	if (!options) {
+		return;
+	}
+	char **names = g_strsplit(options, ",", -1);
+	for (char **name = names; *name; name++) {
+		g_strstrip(*name);
+		if (!**name) {
+			continue;
+		}
+		GtkTreeIter *iter = g_hash_table_lookup(selector->rows, *name);
+		GtkTreeIter parent;
+		if (!iter || !gtk_tree_model_iter_parent(GTK_TREE_MODEL(selector->store), &parent, iter)) {
+			g_ptr_array_add(selector->unknown, g_strdup(*name));
+			continue;
+		}
+		gtk_tree_store_set(selector->store, iter, COLUMN_ACTIVE, TRUE, -1);
+		GtkTreePath *path = gtk_tree_model_get_path(GTK_TREE_MODEL(selector->store), &parent);
+		gtk_tree_view_expand_row(GTK_TREE_VIEW(selector->view), path, FALSE);
+		gtk_tree_path_free(path);
+	}
+	g_strfreev(names);
+}
+
+char *
+option_selector_get_active(GtkWidget *widget)
+{
+	struct option_selector *selector = selector_from_widget(widget);
+	GtkTreeModel *model = GTK_TREE_MODEL(selector->store);
+	GString *options = g_string_new(NULL);
+	GtkTreeIter group, iter;
+
+	gboolean valid_group = gtk_tree_model_get_iter_first(model, &group);
+	for (; valid_group; valid_group = gtk_tree_model_iter_next(model, &group)) {
+		gboolean valid = gtk_tree_model_iter_children(model, &iter, &group);
+		for (; valid; valid = gtk_tree_model_iter_next(model, &iter)) {
+			gboolean active;
+			char *name;
+			gtk_tree_model_get(model, &iter, COLUMN_NAME, &name, COLUMN_ACTIVE, &active, -1);
+			if (active) {
+				g_string_append_printf(options, "%s%s", options->len ? "," : "", name);
+			}
+			g_free(name);
+		}
+	}
+	for (guint i = 0; i < selector->unknown->len; i++) {
+		const char *name = g_ptr_array_index(selector->unknown, i);
+		g_string_append_printf(options, "%s%s", options->len ? "," : "", name);
+	}
+	return g_string_free(options, FALSE);
+}
+
+void
+option_selector_connect_changed(GtkWidget *widget, GCallback callback, gpointer data)
+{
+	struct option_selector *selector = selector_from_widget(widget);
+	g_signal_connect_swapped(selector->store, "row-changed", callback, data);
+}
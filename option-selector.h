@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef OPTION_SELECTOR_H
+#define OPTION_SELECTOR_H
+#include <gtk/gtk.h>
+
+struct keyboard_layouts;
+
+/**
+ * option_selector_new - create a tree of xkb options with check boxes
+ * @layouts: options are taken from layouts->options
+ *
+ * Options are listed under their group, which can be expanded to show them.
+ */
+GtkWidget *option_selector_new(struct keyboard_layouts *layouts);
+
+/**
+ * option_selector_set_active - check options
+ * @options: comma separated list as used in XKB_DEFAULT_OPTIONS
+ */
+void option_selector_set_active(GtkWidget *selector, const char *options);
+
+/**
+ * option_selector_get_active - get checked options
+ * Returns a newly allocated comma separated list, which is empty if nothing
+ * is checked. The caller must g_free() it.
+ */
+char *option_selector_get_active(GtkWidget *selector);
+
+/**
+ * option_selector_connect_changed - call @callback when an option is toggled
+ * @callback: void (*)(gpointer data)
+ */
+void option_selector_connect_changed(GtkWidget *selector, GCallback callback, gpointer data);
+
+#endif /* OPTION_SELECTOR_H */
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <glib.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "reconfigure.h"
+
+bool
+reconfigure_labwc(void)
+{
+	const char *env = g_getenv("LABWC_PID");
+	if (!env || !*env) {
+		return false;
+	}
+
+	char *end;
+	errno = 0;
+	long pid = strtol(env, &end, 10);
+	if (errno || *end || pid <= 1 || pid != (pid_t)pid || pid == getpid()) {
+		fprintf(stderr, "warn: ignoring LABWC_PID=%s\n", env);
+		return false;
+	}
+	if (kill((pid_t)pid, SIGHUP)) {
+		fprintf(stderr, "warn: cannot signal labwc (pid %ld): %s\n", pid, strerror(errno));
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef RECONFIGURE_H
+#define RECONFIGURE_H
+#include <stdbool.h>
+
+/**
+ * reconfigure_labwc - make the running labwc re-read its configuration
+ * labwc sets $LABWC_PID for the processes it launches, so SIGHUP is sent to
+ * that directly instead of running `labwc -r`.
+ * Returns false if labwc could not be signalled, in which case the caller
+ * should fall back to `labwc -r`
+ */
+bool reconfigure_labwc(void);
+
+#endif /* RECONFIGURE_H */
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+"""
+Generate a C header with the models, layouts, variants and options of an xkb
+rules list (usually evdev.lst) as const tables, in the same order as
+keyboard-layouts.c keeps them. If the rules list does not exist on the build
+host, empty tables are generated and the runtime parses the system file.
+
+Usage: gen-keyboard-layouts.py <evdev.lst> <output.h>
+"""
+import os
+import sys
+
+
+def c_string(s):
+    out = []
+    for byte in s.encode('utf-8'):
+        c = chr(byte)
+        if c in '"\\':
+            out.append('\\' + c)
+        elif 0x20 <= byte < 0x7f:
+            out.append(c)
+        else:
+            out.append('\\%03o' % byte)
+    return '"' + ''.join(out) + '"'
+
+
+def parse(filename):
+    layouts, models, options = [], [], []
+    section = None
+    with open(filename, encoding='utf-8') as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith('!'):
+                section = line.lower()
+            elif section in ('! model', '! option'):
+                fields = line.split(None, 1)
+                if section == '! option' and ':' not in fields[0] and '  ' in line:
+                    # group names may contain a space, as in "Compose key"
+                    fields = [s.strip() for s in line.split('  ', 1)]
+                item = (fields[0], fields[1] if len(fields) > 1 else '')
+                (models if section == '! model' else options).append(item)
+            elif section == '! layout':
+                fields = line.split(None, 1)
+                layouts.append((fields[0], '', fields[1] if len(fields) > 1 else ''))
+            elif section == '! variant':
+                fields = line.split(None, 1)
+                if len(fields) < 2 or ':' not in fields[1]:
+                    continue
+                lang, description = fields[1].split(':', 1)
+                layouts.append((lang, fields[0], description.strip()))
+    # same order as cmp_layouts() and cmp_items() in keyboard-layouts.c
+    layouts.sort(key=lambda layout: (layout[0].encode('utf-8'), layout[1].encode('utf-8')))
+    models.sort(key=lambda item: item[0].encode('utf-8'))
+    # options stay in file order, where each group is followed by its options
+    return layouts, models, options
+
+
+def write_items(f, name, items):
+    f.write('static const struct xkb_item %s[] = {\n' % name)
+    for item_name, description in items:
+        f.write('\t{ %s, %s },\n' % (c_string(item_name), c_string(description)))
+    f.write('\t{ NULL, NULL },\n')
+    f.write('};\n')
+
+
+def main():
+    filename, output = sys.argv[1], sys.argv[2]
+    size, mtime, layouts, models, options = -1, -1, [], [], []
+    if os.path.isfile(filename):
+        st = os.stat(filename)
+        size, mtime = st.st_size, int(st.st_mtime)
+        layouts, models, options = parse(filename)
+
+    with open(output, 'w', encoding='utf-8') as f:
+        f.write('/* Generated by gen-keyboard-layouts.py from %s - do not edit */\n' % filename)
+        f.write('#define BUILTIN_LAYOUTS_SOURCE_SIZE %dLL\n' % size)
+        f.write('#define BUILTIN_LAYOUTS_SOURCE_MTIME %dLL\n' % mtime)
+        f.write('#define BUILTIN_LAYOUTS_NR %d\n' % len(layouts))
+        f.write('#define BUILTIN_MODELS_NR %d\n' % len(models))
+        f.write('#define BUILTIN_OPTIONS_NR %d\n\n' % len(options))
+        f.write('static const struct layout builtin_layouts[] = {\n')
+        for lang, variant, description in layouts:
+            f.write('\t{ %s, %s, %s },\n' % (c_string(lang), c_string(variant), c_string(description)))
+        f.write('\t{ NULL, NULL, NULL },\n')
+        f.write('};\n\n')
+        write_items(f, 'builtin_models', models)
+        f.write('\n')
+        write_items(f, 'builtin_options', options)
+
+
+if __name__ == '__main__':
+    main()
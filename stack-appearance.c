@@ -1,19 +1,182 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#include <stdlib.h>
+#include "css-preview.h"
 #include "keyboard-layouts.h"
 #include "state.h"
 #include "stack-appearance.h"
 #include "theme.h"
+#include "theme-preview.h"
+#include "theme-selector.h"
+#include "themerc.h"
 #include "xml.h"
+#if HAVE_LIBARCHIVE
+#include "theme-install.h"
+#endif
+
+static void
+update_openbox_theme_preview(GtkWidget *widget, gpointer data)
+{
+	struct state *state = (struct state *)data;
+	const char *themerc = gtk_combo_box_get_active_id(GTK_COMBO_BOX(state->widgets.openbox_theme_name));
+	int corner_radius = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(state->widgets.corner_radius));
+	theme_preview_update(state->widgets.openbox_theme_preview, themerc, corner_radius);
+}
+
+static void
+update_gtk_theme_preview(GtkWidget *widget, gpointer data)
+{
+	struct state *state = (struct state *)data;
+	GtkComboBox *combo = GTK_COMBO_BOX(state->widgets.gtk_theme_name);
+	char *name = theme_selector_get_active(state->widgets.gtk_theme_name);
+	css_preview_set_theme(state->widgets.gtk_theme_preview, name, gtk_combo_box_get_active_id(combo));
+	g_free(name);
+}
+
+/*
+ * A check button enables the value widget; unchecked means not overridden.
+ * A @value which cannot be shown cannot be checked either, so it is never
+ * written over.
+ */
+static void
+add_override(GtkWidget *grid, int row, const char *label, GtkWidget *widget,
+		const char *value, bool valid)
+{
+	GtkWidget *check = gtk_check_button_new_with_label(label);
+	gtk_widget_set_halign(check, GTK_ALIGN_START);
+	g_object_bind_property(check, "active", widget, "sensitive", G_BINDING_SYNC_CREATE);
+	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(check), valid);
+	if (value && !valid) {
+		char *tooltip = g_strdup_printf(_("Unknown value \"%s\" in themerc-override"), value);
+		gtk_widget_set_tooltip_text(check, tooltip);
+		gtk_widget_set_sensitive(check, FALSE);
+		g_free(tooltip);
+	}
+	gtk_grid_attach(GTK_GRID(grid), check, 0, row, 1, 1);
+	gtk_grid_attach(GTK_GRID(grid), widget, 1, row, 1, 1);
+}
+
+static GtkWidget *
+override_spin_button(struct state *state, GtkWidget *grid, int row, const char *label,
+		const char *key, int max)
+{
+	const char *value = kvfile_get(&state->themerc_override, key);
+	char *end = NULL;
+	long number = value ? strtol(value, &end, 10) : 0;
+	bool valid = value && end != value && !*end && number >= 0 && number <= max;
+	GtkWidget *spin = gtk_spin_button_new_with_range(0, max, 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(spin), valid ? number : 0);
+	add_override(grid, row, label, spin, value, valid);
+	return spin;
+}
+
+static GtkWidget *
+override_color_button(struct state *state, GtkWidget *grid, int row, const char *label,
+		const char *key)
+{
+	const char *value = kvfile_get(&state->themerc_override, key);
+	struct themerc_color color;
+	bool valid = value && themerc_parse_color(&color, value);
+	GtkWidget *button = gtk_color_button_new();
+	gtk_color_chooser_set_use_alpha(GTK_COLOR_CHOOSER(button), TRUE);
+	if (valid) {
+		GdkRGBA rgba = { color.r, color.g, color.b, color.a };
+		gtk_color_chooser_set_rgba(GTK_COLOR_CHOOSER(button), &rgba);
+	}
+	gtk_widget_set_halign(button, GTK_ALIGN_START);
+	add_override(grid, row, label, button, value, valid);
+	return button;
+}
+
+#if HAVE_LIBARCHIVE
+static void
+result_free(struct theme_install_result *result)
+{
+	theme_install_result_finish(result);
+	g_free(result);
+}
+
+static void
+install_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	GError *err = NULL;
+	struct theme_install_result *result = g_new0(struct theme_install_result, 1);
+	if (!theme_install(task_data, result, &err)) {
+		result_free(result);
+		g_task_return_error(task, err);
+		return;
+	}
+	g_task_return_pointer(task, result, (GDestroyNotify)result_free);
+}
+
+/* add the newly installed @themes to @selector, if there is one */
+static void
+add_installed(GtkWidget *selector, struct themes *themes)
+{
+	if (!selector) {
+		return;
+	}
+	for (int i = 0; i < themes->nr; ++i) {
+		theme_selector_add(selector, themes->data[i].name, themes->data[i].path);
+	}
+}
+
+static void
+install_done(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	struct state *state = (struct state *)user_data;
+	GError *err = NULL;
+
+	gtk_widget_set_sensitive(GTK_WIDGET(source_object), TRUE);
+	struct theme_install_result *result = g_task_propagate_pointer(G_TASK(res), &err);
+	if (!result) {
+		GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(state->window),
+			GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT, GTK_MESSAGE_ERROR,
+			GTK_BUTTONS_CLOSE, _("Cannot install theme: %s"), err->message);
+		gtk_dialog_run(GTK_DIALOG(dialog));
+		gtk_widget_destroy(dialog);
+		g_error_free(err);
+		return;
+	}
+	add_installed(state->widgets.openbox_theme_name, &result->openbox);
+	add_installed(state->widgets.gtk_theme_name, &result->gtk);
+	add_installed(state->widgets.icon_theme_name, &result->icon);
+	add_installed(state->widgets.cursor_theme_name, &result->cursor);
+	result_free(result);
+}
+
+static void
+install_theme(GtkWidget *button, gpointer data)
+{
+	struct state *state = (struct state *)data;
+	GtkWidget *dialog = gtk_file_chooser_dialog_new(_("Install Theme from Archive"),
+		GTK_WINDOW(state->window), GTK_FILE_CHOOSER_ACTION_OPEN,
+		_("_Cancel"), GTK_RESPONSE_CANCEL, _("_Install"), GTK_RESPONSE_ACCEPT, NULL);
+
+	GtkFileFilter *filter = gtk_file_filter_new();
+	gtk_file_filter_set_name(filter, _("Theme Archives"));
+	const char *patterns[] = { "*.tar.gz", "*.tgz", "*.tar.xz", "*.txz", "*.tar.bz2", "*.obt" };
+	for (size_t i = 0; i < G_N_ELEMENTS(patterns); i++) {
+		gtk_file_filter_add_pattern(filter, patterns[i]);
+	}
+	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
+
+	if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+		char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+		gtk_widget_set_sensitive(button, FALSE);
+		GTask *task = g_task_new(button, NULL, install_done, state);
+		g_task_set_task_data(task, filename, g_free);
+		g_task_run_in_thread(task, install_thread);
+		g_object_unref(task);
+	}
+	gtk_widget_destroy(dialog);
+}
+#endif
 
 void
-stack_appearance_init(struct state *state, GtkWidget *stack)
+stack_appearance_init(struct state *state, GtkWidget *vbox)
 {
 	GtkWidget *widget;
 
-	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	gtk_stack_add_named(GTK_STACK(stack), vbox, "appearance");
-	gtk_container_child_set(GTK_CONTAINER(stack), vbox, "title", _("Appearance"), NULL);
-
 	/* the grid with settings */
 	int row = 0;
 	GtkWidget *grid = gtk_grid_new();
@@ -26,18 +189,8 @@ stack_appearance_init(struct state *state, GtkWidget *stack)
 	widget = gtk_label_new(_("Openbox Theme"));
 	gtk_widget_set_halign(widget, GTK_ALIGN_START);
 	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
-	state->widgets.openbox_theme_name = gtk_combo_box_text_new();
-	int active = -1;
-	char *active_id = xml_get("/labwc_config/theme/name");
-	struct theme *theme;
-	for (int i = 0; i < openbox_themes.nr; ++i) {
-		theme = openbox_themes.data + i;
-		if (active_id && !strcmp(theme->name, active_id)) {
-			active = i;
-		}
-		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->widgets.openbox_theme_name), theme->name);
-	}
-	gtk_combo_box_set_active(GTK_COMBO_BOX(state->widgets.openbox_theme_name), active);
+	state->widgets.openbox_theme_name = theme_selector_new(&openbox_themes);
+	theme_selector_set_active(state->widgets.openbox_theme_name, xml_get("/labwc_config/theme/name"));
 	gtk_grid_attach(GTK_GRID(grid), state->widgets.openbox_theme_name, 1, row++, 1, 1);
 	theme_free_vector(&openbox_themes);
 
@@ -50,6 +203,14 @@ stack_appearance_init(struct state *state, GtkWidget *stack)
 	gtk_spin_button_set_value(GTK_SPIN_BUTTON(state->widgets.corner_radius), xml_get_int("/labwc_config/theme/cornerradius"));
 	gtk_grid_attach(GTK_GRID(grid), state->widgets.corner_radius, 1, row++, 1, 1);
 
+	/* openbox theme preview */
+	state->widgets.openbox_theme_preview = gtk_image_new();
+	gtk_widget_set_halign(state->widgets.openbox_theme_preview, GTK_ALIGN_START);
+	gtk_grid_attach(GTK_GRID(grid), state->widgets.openbox_theme_preview, 1, row++, 1, 1);
+	g_signal_connect(state->widgets.openbox_theme_name, "changed", G_CALLBACK(update_openbox_theme_preview), state);
+	g_signal_connect(state->widgets.corner_radius, "value-changed", G_CALLBACK(update_openbox_theme_preview), state);
+	update_openbox_theme_preview(NULL, state);
+
         /* button layout */
 	widget = gtk_label_new(_("Button Layout"));
 	gtk_widget_set_halign(widget, GTK_ALIGN_START);
@@ -86,21 +247,19 @@ stack_appearance_init(struct state *state, GtkWidget *stack)
 	widget = gtk_label_new(_("Gtk Theme"));
 	gtk_widget_set_halign(widget, GTK_ALIGN_START);
 	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
-	state->widgets.gtk_theme_name = gtk_combo_box_text_new();
-
-	active_id = g_settings_get_string(state->settings, "gtk-theme");
-	active = -1;
-	for (int i = 0; i < gtk_themes.nr; ++i) {
-		theme = gtk_themes.data + i;
-		if (!strcmp(theme->name, active_id)) {
-			active = i;
-		}
-		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->widgets.gtk_theme_name), theme->name);
-	}
-	gtk_combo_box_set_active(GTK_COMBO_BOX(state->widgets.gtk_theme_name), active);
+	state->widgets.gtk_theme_name = theme_selector_new(&gtk_themes);
+	char *active_id = g_settings_get_string(state->settings, "gtk-theme");
+	theme_selector_set_active(state->widgets.gtk_theme_name, active_id);
+	g_free(active_id);
 	gtk_grid_attach(GTK_GRID(grid), state->widgets.gtk_theme_name, 1, row++, 1, 1);
 	theme_free_vector(&gtk_themes);
 
+	/* gtk theme preview */
+	state->widgets.gtk_theme_preview = css_preview_new();
+	gtk_grid_attach(GTK_GRID(grid), state->widgets.gtk_theme_preview, 1, row++, 1, 1);
+	g_signal_connect(state->widgets.gtk_theme_name, "changed", G_CALLBACK(update_gtk_theme_preview), state);
+	update_gtk_theme_preview(NULL, state);
+
 	/* icon theme combobox */
 	struct themes icon_themes = { 0 };
 	theme_find(&icon_themes, "icons", NULL);
@@ -108,19 +267,37 @@ stack_appearance_init(struct state *state, GtkWidget *stack)
 	widget = gtk_label_new(_("Icon Theme"));
 	gtk_widget_set_halign(widget, GTK_ALIGN_START);
 	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
-	state->widgets.icon_theme_name = gtk_combo_box_text_new();
-
+	state->widgets.icon_theme_name = theme_selector_new(&icon_themes);
 	active_id = g_settings_get_string(state->settings, "icon-theme");
-	active = -1;
-	for (int i = 0; i < icon_themes.nr; ++i) {
-		theme = icon_themes.data + i;
-		if (!strcmp(theme->name, active_id)) {
-			active = i;
-		}
-		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->widgets.icon_theme_name), theme->name);
-	}
-	gtk_combo_box_set_active(GTK_COMBO_BOX(state->widgets.icon_theme_name), active);
+	theme_selector_set_active(state->widgets.icon_theme_name, active_id);
+	g_free(active_id);
 	gtk_grid_attach(GTK_GRID(grid), state->widgets.icon_theme_name, 1, row++, 1, 1);
 	theme_free_vector(&icon_themes);
+
+	/* ~/.config/labwc/themerc-override */
+	widget = gtk_label_new(NULL);
+	gtk_label_set_markup(GTK_LABEL(widget), _("<b>Theme Overrides</b>"));
+	gtk_widget_set_halign(widget, GTK_ALIGN_START);
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, row++, 2, 1);
+	state->widgets.override_border_width = override_spin_button(state, grid, row++,
+		_("Border Width"), "border.width", 20);
+	state->widgets.override_padding_height = override_spin_button(state, grid, row++,
+		_("Title Padding"), "padding.height", 20);
+	state->widgets.override_active_title_bg = override_color_button(state, grid, row++,
+		_("Active Title Color"), "window.active.title.bg.color");
+	state->widgets.override_active_label_text = override_color_button(state, grid, row++,
+		_("Active Title Text Color"), "window.active.label.text.color");
+	state->widgets.override_inactive_title_bg = override_color_button(state, grid, row++,
+		_("Inactive Title Color"), "window.inactive.title.bg.color");
+	state->widgets.override_inactive_label_text = override_color_button(state, grid, row++,
+		_("Inactive Title Text Color"), "window.inactive.label.text.color");
+
+#if HAVE_LIBARCHIVE
+	/* install theme button */
+	widget = gtk_button_new_with_label(_("Install Theme from Archive..."));
+	gtk_widget_set_halign(widget, GTK_ALIGN_START);
+	g_signal_connect(widget, "clicked", G_CALLBACK(install_theme), state);
+	gtk_grid_attach(GTK_GRID(grid), widget, 1, row++, 1, 1);
+#endif
 }
 
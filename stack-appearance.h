@@ -5,6 +5,6 @@
 
 struct state;
 
-void stack_appearance_init(struct state *state, GtkWidget *stack);
+void stack_appearance_init(struct state *state, GtkWidget *vbox);
 
 #endif /* STACK_APPEARANCE_H */
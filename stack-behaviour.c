@@ -3,16 +3,42 @@
 #include "state.h"
 #include "stack-behaviour.h"
 #include "theme.h"
+#include "thumbnail.h"
 #include "xml.h"
 
-static void update_preview(const char *filename, GtkWidget *preview_image) {
-    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file_at_size(filename, 64, 64, NULL);
-    if (pixbuf) {
-        gtk_image_set_from_pixbuf(GTK_IMAGE(preview_image), pixbuf);
-        g_object_unref(pixbuf);
-    } else {
-        gtk_image_clear(GTK_IMAGE(preview_image));
-    }
+static GCancellable *preview_cancellable;
+
+static void
+preview_loaded(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	GtkWidget *preview_image = user_data;
+	GError *err = NULL;
+	GdkPixbuf *pixbuf = thumbnail_load_finish(result, &err);
+	if (pixbuf) {
+		gtk_image_set_from_pixbuf(GTK_IMAGE(preview_image), pixbuf);
+		g_object_unref(pixbuf);
+	} else if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		gtk_image_clear(GTK_IMAGE(preview_image));
+	}
+	g_clear_error(&err);
+	g_object_unref(preview_image);
+}
+
+/* Load preview on a worker thread so that large or remote images don't block */
+static void
+update_preview(const char *filename, GtkWidget *preview_image)
+{
+	if (preview_cancellable) {
+		g_cancellable_cancel(preview_cancellable);
+		g_clear_object(&preview_cancellable);
+	}
+	if (!filename || !*filename) {
+		gtk_image_clear(GTK_IMAGE(preview_image));
+		return;
+	}
+	preview_cancellable = g_cancellable_new();
+	thumbnail_load_async(filename, 64, preview_cancellable, preview_loaded,
+		g_object_ref(preview_image));
 }
 
 static void on_button_clicked(GtkWidget *button, gpointer user_data)
@@ -47,9 +73,6 @@ static void on_button_clicked(GtkWidget *button, gpointer user_data)
         filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
         // Store the filename in the state widget for the update function
         gtk_entry_set_text(GTK_ENTRY(state->widgets.icon_path), filename);
-        // Update the XML immediately
-        xml_set("/labwc_config/theme/fallbackIcon", filename);
-        xml_save();
         // Update the preview
         update_preview(filename, state->widgets.icon_preview);
         g_free(filename);
@@ -58,13 +81,9 @@ static void on_button_clicked(GtkWidget *button, gpointer user_data)
     gtk_widget_destroy(dialog);
 }
 
-void stack_behaviour_init(struct state *state, GtkWidget *stack)
+void stack_behaviour_init(struct state *state, GtkWidget *vbox)
 {
 	GtkWidget *widget;
-state->widgets.icon_path = gtk_entry_new();
-	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	gtk_stack_add_named(GTK_STACK(stack), vbox, "behaviour");
-	gtk_container_child_set(GTK_CONTAINER(stack), vbox, "title", "Behaviour", NULL);
 
 	/* the grid with settings */
 	int row = 0;
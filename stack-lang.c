@@ -3,53 +3,111 @@
 #include <ctype.h>
 #include "environment.h"
 #include "keyboard-layouts.h"
+#include "layout-selector.h"
+#include "option-selector.h"
 #include "state.h"
 #include "stack-lang.h"
 #include "theme.h"
 #include "xml.h"
+#if HAVE_XKBCOMMON
+#include "keyboard-preview.h"
+#endif
+
+static void
+keyboard_layouts_free(struct keyboard_layouts *keyboard_layouts)
+{
+	keyboard_layouts_finish(keyboard_layouts);
+	g_free(keyboard_layouts);
+}
+
+#if HAVE_XKBCOMMON
+static void
+update_keyboard_preview(struct state *state)
+{
+	struct layout *layout = layout_selector_get_active(state->widgets.keyboard_layout);
+	const char *model = gtk_combo_box_get_active_id(GTK_COMBO_BOX(state->widgets.keyboard_model));
+	char *options = option_selector_get_active(state->widgets.keyboard_options);
+	keyboard_preview_update(state->widgets.keyboard_preview, layout ? layout->lang : NULL,
+		layout ? layout->variant : NULL, model, options);
+	g_free(options);
+}
+#endif
 
 void
-stack_lang_init(struct state *state, GtkWidget *stack)
+stack_lang_init(struct state *state, GtkWidget *vbox)
 {
 	GtkWidget *widget;
 
-	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	gtk_stack_add_named(GTK_STACK(stack), vbox, "lang");
-	gtk_container_child_set(GTK_CONTAINER(stack), vbox, "title", _("Language & Region"), NULL);
-
 	/* the grid with settings */
 	int row = 0;
 	GtkWidget *grid = gtk_grid_new();
 	g_object_set(grid, "margin", 20, "row-spacing", 10, "column-spacing", 10, NULL);
 	gtk_box_pack_start(GTK_BOX(vbox), grid, TRUE, TRUE, 5);
 
-	/* keyboard layout */
-	GList *keyboard_layouts = NULL;
-	keyboard_layouts_init(&keyboard_layouts, "/usr/share/X11/xkb/rules/evdev.lst");
+	/* rules list with all sections; the vector lives as long as the page */
+	struct keyboard_layouts *keyboard_layouts = g_new0(struct keyboard_layouts, 1);
+	keyboard_layouts_init(keyboard_layouts, XKB_RULES_LIST);
+	g_object_set_data_full(G_OBJECT(vbox), "keyboard-layouts", keyboard_layouts,
+		(GDestroyNotify)keyboard_layouts_free);
 
 	widget = gtk_label_new(_("Keyboard Layout"));
 	gtk_widget_set_halign(widget, GTK_ALIGN_START);
+	gtk_widget_set_valign(widget, GTK_ALIGN_START);
 	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
-	state->widgets.keyboard_layout = gtk_combo_box_text_new();
+	state->widgets.keyboard_layout = layout_selector_new(keyboard_layouts);
+	gtk_widget_set_hexpand(state->widgets.keyboard_layout, TRUE);
+	gtk_widget_set_vexpand(state->widgets.keyboard_layout, TRUE);
 
-	char xkb_default_layout[1024];
+	char xkb_default_layout[1024] = { 0 };
+	char xkb_default_variant[1024] = { 0 };
 	environment_get(xkb_default_layout, sizeof(xkb_default_layout), "XKB_DEFAULT_LAYOUT");
-	int active = -1;
-
-	GList *iter;
-	int i = 0;
-	for (iter = keyboard_layouts; iter; iter = iter->next) {
-		struct layout *layout = (struct layout *)iter->data;
-		if (!strcmp(layout->lang, xkb_default_layout)) {
-			active = i;
-		}
-		char buf[256];
-		snprintf(buf, sizeof(buf), "%s  %s", layout->lang, layout->description);
-		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->widgets.keyboard_layout), buf);
-		++i;
-	}
-	gtk_combo_box_set_active(GTK_COMBO_BOX(state->widgets.keyboard_layout), active);
+	environment_get(xkb_default_variant, sizeof(xkb_default_variant), "XKB_DEFAULT_VARIANT");
+	layout_selector_set_active(state->widgets.keyboard_layout, xkb_default_layout,
+		xkb_default_variant);
 	gtk_grid_attach(GTK_GRID(grid), state->widgets.keyboard_layout, 1, row++, 1, 1);
-	keyboard_layouts_finish(keyboard_layouts);
+
+#if HAVE_XKBCOMMON
+	/* keyboard preview */
+	state->widgets.keyboard_preview = gtk_image_new();
+	gtk_widget_set_halign(state->widgets.keyboard_preview, GTK_ALIGN_START);
+	gtk_grid_attach(GTK_GRID(grid), state->widgets.keyboard_preview, 1, row++, 1, 1);
+#endif
+
+	/* keyboard model */
+	widget = gtk_label_new(_("Keyboard Model"));
+	gtk_widget_set_halign(widget, GTK_ALIGN_START);
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
+	state->widgets.keyboard_model = gtk_combo_box_text_new();
+	for (int i = 0; i < keyboard_layouts->nr_models; i++) {
+		struct xkb_item *model = keyboard_layouts->models + i;
+		gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(state->widgets.keyboard_model),
+			model->name, model->description);
+	}
+	char xkb_default_model[1024] = { 0 };
+	environment_get(xkb_default_model, sizeof(xkb_default_model), "XKB_DEFAULT_MODEL");
+	gtk_combo_box_set_active_id(GTK_COMBO_BOX(state->widgets.keyboard_model), xkb_default_model);
+	gtk_grid_attach(GTK_GRID(grid), state->widgets.keyboard_model, 1, row++, 1, 1);
+
+	/* keyboard options */
+	widget = gtk_label_new(_("Keyboard Options"));
+	gtk_widget_set_halign(widget, GTK_ALIGN_START);
+	gtk_widget_set_valign(widget, GTK_ALIGN_START);
+	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
+	state->widgets.keyboard_options = option_selector_new(keyboard_layouts);
+	gtk_widget_set_vexpand(state->widgets.keyboard_options, TRUE);
+	char xkb_default_options[1024] = { 0 };
+	environment_get(xkb_default_options, sizeof(xkb_default_options), "XKB_DEFAULT_OPTIONS");
+	option_selector_set_active(state->widgets.keyboard_options, xkb_default_options);
+	gtk_grid_attach(GTK_GRID(grid), state->widgets.keyboard_options, 1, row++, 1, 1);
+
+#if HAVE_XKBCOMMON
+	layout_selector_connect_changed(state->widgets.keyboard_layout,
+		G_CALLBACK(update_keyboard_preview), state);
+	g_signal_connect_swapped(state->widgets.keyboard_model, "changed",
+		G_CALLBACK(update_keyboard_preview), state);
+	option_selector_connect_changed(state->widgets.keyboard_options,
+		G_CALLBACK(update_keyboard_preview), state);
+	update_keyboard_preview(state);
+#endif
 }
 
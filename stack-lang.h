@@ -5,6 +5,6 @@
 
 struct state;
 
-void stack_lang_init(struct state *state, GtkWidget *stack);
+void stack_lang_init(struct state *state, GtkWidget *vbox);
 
 #endif /* STACK_LANG_H */
@@ -3,17 +3,14 @@
 #include "state.h"
 #include "stack-mouse.h"
 #include "theme.h"
+#include "theme-selector.h"
 #include "xml.h"
 
 void
-stack_mouse_init(struct state *state, GtkWidget *stack)
+stack_mouse_init(struct state *state, GtkWidget *vbox)
 {
 	GtkWidget *widget;
 
-	GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	gtk_stack_add_named(GTK_STACK(stack), vbox, "mouse");
-	gtk_container_child_set(GTK_CONTAINER(stack), vbox, "title", _("Mouse & Touchpad"), NULL);
-
 	/* the grid with settings */
 	int row = 0;
 	GtkWidget *grid = gtk_grid_new();
@@ -27,18 +24,10 @@ stack_mouse_init(struct state *state, GtkWidget *stack)
 	widget = gtk_label_new(_("Cursor Theme"));
 	gtk_widget_set_halign(widget, GTK_ALIGN_START);
 	gtk_grid_attach(GTK_GRID(grid), widget, 0, row, 1, 1);
-	state->widgets.cursor_theme_name = gtk_combo_box_text_new();
-
+	state->widgets.cursor_theme_name = theme_selector_new(&cursor_themes);
 	char *active_id = g_settings_get_string(state->settings, "cursor-theme");
-	int active = -1;
-	for (int i = 0; i < cursor_themes.nr; ++i) {
-		struct theme *theme = cursor_themes.data + i;
-		if (!strcmp(theme->name, active_id)) {
-			active = i;
-		}
-		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->widgets.cursor_theme_name), theme->name);
-	}
-	gtk_combo_box_set_active(GTK_COMBO_BOX(state->widgets.cursor_theme_name), active);
+	theme_selector_set_active(state->widgets.cursor_theme_name, active_id);
+	g_free(active_id);
 	gtk_grid_attach(GTK_GRID(grid), state->widgets.cursor_theme_name, 1, row++, 1, 1);
 	theme_free_vector(&cursor_themes);
 
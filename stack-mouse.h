@@ -5,6 +5,6 @@
 
 struct state;
 
-void stack_mouse_init(struct state *state, GtkWidget *stack);
+void stack_mouse_init(struct state *state, GtkWidget *vbox);
 
 #endif /* STACK_MOUSE_H */
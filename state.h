@@ -2,7 +2,9 @@
 #ifndef STATE_H
 #define STATE_H
 #include <gtk/gtk.h>
+#include "apply.h"
 #include "config.h"
+#include "kvfile.h"
 #if HAVE_NLS
 #include <libintl.h>
 #include <locale.h>
@@ -16,12 +18,23 @@ struct state {
 	struct {
 		GtkWidget *corner_radius;
 		GtkWidget *openbox_theme_name;
+		GtkWidget *openbox_theme_preview;
 		GtkWidget *gtk_theme_name;
+		GtkWidget *gtk_theme_preview;
+		GtkWidget *override_border_width;
+		GtkWidget *override_padding_height;
+		GtkWidget *override_active_title_bg;
+		GtkWidget *override_inactive_title_bg;
+		GtkWidget *override_active_label_text;
+		GtkWidget *override_inactive_label_text;
 		GtkWidget *icon_theme_name;
 		GtkWidget *cursor_theme_name;
 		GtkWidget *cursor_size;
 		GtkWidget *natural_scroll;
 		GtkWidget *keyboard_layout;
+		GtkWidget *keyboard_model;
+		GtkWidget *keyboard_options;
+		GtkWidget *keyboard_preview;
 		GtkWidget *drop_shadows;
 		GtkWidget *button_layout;
 		GtkWidget *show_title;
@@ -43,10 +56,28 @@ struct state {
 		    GtkWidget *file_button;
 			    GtkWidget *icon_path;
     GtkWidget *icon_preview;
+		GtkWidget *update_button;
+		GtkWidget *update_spinner;
+		GtkWidget *update_status;
+		GtkWidget *auto_apply;
 
 
 	} widgets;
 	GSettings *settings;
+	struct kvfile themerc_override;
+
+	/* settings as loaded or last applied, see update.c */
+	struct snapshot *snapshot;
+
+	/* files which exist but could not be read are never written over */
+	bool unreadable[BACKEND_NR];
+
+	/* files which are saved again by the next update() */
+	bool save_failed[BACKEND_NR];
+
+	/* auto-apply, see update_add_widgets() */
+	guint debounce_ms;
+	guint auto_apply_source;
 };
 
 #endif /* STATE_H */
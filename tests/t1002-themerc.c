@@ -0,0 +1,81 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../themerc.h"
+
+static const char themerc[] =
+	"# comment: with colon\n"
+	"border.width: 3\n"
+	"border.color: #112233\n"
+	"window.inactive.border.color: #445566\n"
+	"  window.active.title.bg.color:   #abc  \n"
+	"window.active.label.text.color: #ff000080\n"
+	"window.active.button.unpressed.image.color: red\n"
+	"menu.items.bg.color: #000000\n";
+
+static const char close_xbm[] =
+	"#define close_width 4\n"
+	"#define close_height 2\n"
+	"static unsigned char close_bits[] = {\n"
+	"   0x09, 0x06 };\n";
+
+static void
+write_file(const char *dir, const char *name, const char *content)
+{
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE *fp = fopen(path, "w");
+	if (!fp)
+		exit(EXIT_FAILURE);
+	fputs(content, fp);
+	fclose(fp);
+}
+
+static bool
+color_equal(struct themerc_color *c, double r, double g, double b, double a)
+{
+	return c->r == r && c->g == g && c->b == b && c->a == a;
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1002-themerc_XXXXXX";
+	char filename[4096];
+	struct themerc rc;
+
+	plan(9);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	write_file(dir, "themerc", themerc);
+	write_file(dir, "close.xbm", close_xbm);
+	snprintf(filename, sizeof(filename), "%s/themerc", dir);
+
+	diag("parse the keys needed for the titlebar preview");
+	ok1(themerc_parse(&rc, filename));
+	ok1(rc.border_width == 3);
+	ok1(rc.padding_height == 3);
+	ok1(color_equal(&rc.active_title_bg, 0xaa / 255.0, 0xbb / 255.0, 0xcc / 255.0, 1.0));
+	ok1(color_equal(&rc.active_label_text, 1.0, 0.0, 0.0, 0x80 / 255.0));
+
+	diag("window.*.border.color takes precedence over border.color");
+	ok1(color_equal(&rc.active_border, 0x11 / 255.0, 0x22 / 255.0, 0x33 / 255.0, 1.0));
+	ok1(color_equal(&rc.inactive_border, 0x44 / 255.0, 0x55 / 255.0, 0x66 / 255.0, 1.0));
+
+	diag("read button bitmap and fall back to built-in ones");
+	ok1(rc.buttons[THEMERC_BUTTON_CLOSE].width == 4
+		&& rc.buttons[THEMERC_BUTTON_CLOSE].bits[0] == 0x09
+		&& rc.buttons[THEMERC_BUTTON_CLOSE].bits[1] == 0x06);
+	ok1(rc.buttons[THEMERC_BUTTON_MAX].width == 6);
+
+	snprintf(filename, sizeof(filename), "%s/close.xbm", dir);
+	unlink(filename);
+	snprintf(filename, sizeof(filename), "%s/themerc", dir);
+	unlink(filename);
+	rmdir(dir);
+	return exit_status();
+}
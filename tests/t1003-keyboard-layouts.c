@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../keyboard-layouts.h"
+
+static const char evdev_lst[] =
+	"! model\n"
+	"  pc105           Generic 105-key PC\n"
+	"\n"
+	"! layout\n"
+	"  us              English (US)\n"
+	"  de              German\n"
+	"  gb              English (UK)\n"
+	"\n"
+	"! variant\n"
+	"  nodeadkeys      de: German (no dead keys)\n"
+	"\n"
+	"! option\n"
+	"  grp             Switching to another layout\n"
+	"  grp:toggle      Right Alt\n"
+	"  Compose key     Position of Compose key\n"
+	"  compose:ralt    Right Alt\n"
+	"  ctrl            Ctrl position\n"
+	"  ctrl:nocaps     Caps Lock as Ctrl\n";
+
+static bool
+is_expected(struct keyboard_layouts *layouts)
+{
+	return layouts->nr == 4
+		&& !strcmp(layouts->data[0].lang, "de")
+		&& !strcmp(layouts->data[0].variant, "")
+		&& !strcmp(layouts->data[0].description, "German")
+		&& !strcmp(layouts->data[1].lang, "de")
+		&& !strcmp(layouts->data[1].variant, "nodeadkeys")
+		&& !strcmp(layouts->data[1].description, "German (no dead keys)")
+		&& !strcmp(layouts->data[2].lang, "gb")
+		&& !strcmp(layouts->data[2].description, "English (UK)")
+		&& !strcmp(layouts->data[3].lang, "us")
+		&& layouts->nr_models == 1
+		&& !strcmp(layouts->models[0].name, "pc105")
+		&& layouts->nr_options == 6
+		&& !strcmp(layouts->options[0].name, "grp")
+		&& !strcmp(layouts->options[1].description, "Right Alt")
+		&& !strcmp(layouts->options[2].name, "Compose key")
+		&& !strcmp(layouts->options[3].name, "compose:ralt");
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1003-layouts_XXXXXX";
+	struct keyboard_layouts layouts;
+
+	plan(13);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	setenv("XDG_CACHE_HOME", dir, 1);
+	char *filename = g_build_filename(dir, "evdev.lst", NULL);
+	char *cache = g_build_filename(dir, "labwc-tweaks-gtk", "keyboard-layouts.cache", NULL);
+	g_file_set_contents(filename, evdev_lst, -1, NULL);
+
+	diag("parse all sections in one pass, keeping options in file order");
+	keyboard_layouts_init(&layouts, filename);
+	ok1(is_expected(&layouts));
+	ok1(!layouts.map);
+	keyboard_layouts_finish(&layouts);
+
+	diag("second run uses the mmap'd cache");
+	ok1(g_file_test(cache, G_FILE_TEST_EXISTS));
+	keyboard_layouts_init(&layouts, filename);
+	ok1(layouts.map && is_expected(&layouts));
+	keyboard_layouts_finish(&layouts);
+
+	diag("look up layouts, variants by parent, models and options");
+	keyboard_layouts_init(&layouts, filename);
+	ok1(keyboard_layouts_find(&layouts, "de", NULL) == 0);
+	ok1(keyboard_layouts_find(&layouts, "de", "nodeadkeys") == 1);
+	ok1(keyboard_layouts_find(&layouts, "fr", "") == -1);
+	int nr;
+	struct layout *variants = keyboard_layouts_find_variants(&layouts, "de", &nr);
+	ok1(nr == 1 && variants == layouts.data + 1);
+	ok1(!keyboard_layouts_find_variants(&layouts, "us", &nr) && !nr);
+	ok1(keyboard_layouts_find_option(&layouts, "ctrl:nocaps")
+		&& keyboard_layouts_find_model(&layouts, "pc105"));
+	keyboard_layouts_finish(&layouts);
+
+	diag("cache is invalidated when evdev.lst changes size");
+	g_file_set_contents(filename, "! layout\n  fr  French\n", -1, NULL);
+	keyboard_layouts_init(&layouts, filename);
+	ok1(!layouts.map && layouts.nr == 1);
+	ok1(!strcmp(layouts.data[0].lang, "fr"));
+	keyboard_layouts_finish(&layouts);
+
+	diag("missing rules list falls back to built-in table instead of exiting");
+	keyboard_layouts_init(&layouts, "/nonexistent/evdev.lst");
+	ok1(!layouts.map && !layouts.buf);
+	keyboard_layouts_finish(&layouts);
+
+	unlink(cache);
+	unlink(filename);
+	char *cache_dir = g_path_get_dirname(cache);
+	rmdir(cache_dir);
+	rmdir(dir);
+	g_free(cache_dir);
+	g_free(cache);
+	g_free(filename);
+	return exit_status();
+}
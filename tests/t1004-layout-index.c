@@ -0,0 +1,61 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap.h"
+#include "../keyboard-layouts.h"
+#include "../layout-index.h"
+
+static struct layout data[] = {
+	{ "de", "", "German" },
+	{ "de", "nodeadkeys", "German (no dead keys)" },
+	{ "gb", "", "English (UK)" },
+	{ "us", "", "English (US)" },
+	{ "us", "dvorak", "English (Dvorak)" },
+	{ "se", "", "Swedish" },
+};
+
+#define NR (int)(sizeof(data) / sizeof(data[0]))
+
+static bool
+only(gboolean *matches, const char *expected)
+{
+	for (int i = 0; i < NR; i++) {
+		bool want = !!strchr(expected, '0' + i);
+		if (want != !!matches[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	struct keyboard_layouts layouts = { .data = data, .nr = NR };
+	struct layout_index index;
+	gboolean matches[NR];
+
+	plan(8);
+
+	layout_index_init(&index, &layouts);
+
+	diag("empty query matches everything");
+	ok1(layout_index_search(&index, "", matches) == NR);
+
+	diag("match layout codes, variants and descriptions by prefix");
+	ok1(layout_index_search(&index, "de", matches) == 2 && only(matches, "01"));
+	ok1(layout_index_search(&index, "dvo", matches) == 1 && only(matches, "4"));
+	ok1(layout_index_search(&index, "engl", matches) == 3 && only(matches, "234"));
+
+	diag("case-insensitive substring within words");
+	ok1(layout_index_search(&index, "WEDISH", matches) == 1 && only(matches, "5"));
+
+	diag("all words must match");
+	ok1(layout_index_search(&index, "english us", matches) == 2 && only(matches, "34"));
+	ok1(layout_index_search(&index, "german dead", matches) == 1 && only(matches, "1"));
+	ok1(layout_index_search(&index, "xyz", matches) == 0);
+
+	layout_index_finish(&index);
+	return exit_status();
+}
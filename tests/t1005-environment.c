@@ -0,0 +1,79 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../environment.h"
+
+static const char original[] =
+	"# cursor\n"
+	"MY_XCURSOR_THEME=mine\n"
+	"XCURSOR_THEME=Adwaita\n"
+	"\n"
+	"  XKB_DEFAULT_LAYOUT = us  \n"
+	"XKB_DEFAULT_VARIANT=intl\n";
+
+static const char expected[] =
+	"# cursor\n"
+	"MY_XCURSOR_THEME=mine\n"
+	"XCURSOR_THEME=breeze\n"
+	"\n"
+	"XKB_DEFAULT_LAYOUT=de\n"
+	"XCURSOR_SIZE=32\n";
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1005-environment_XXXXXX";
+	char buf[256] = { 0 };
+	char *contents = NULL;
+
+	plan(8);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	char *filename = g_build_filename(dir, "environment", NULL);
+	g_file_set_contents(filename, original, -1, NULL);
+
+	diag("look up keys exactly, ignoring surrounding whitespace");
+	environment_init(filename);
+	environment_get(buf, sizeof(buf), "XCURSOR_THEME");
+	ok1(!strcmp(buf, "Adwaita"));
+	environment_get(buf, sizeof(buf), "XKB_DEFAULT_LAYOUT");
+	ok1(!strcmp(buf, "us"));
+	buf[0] = '\0';
+	environment_get(buf, sizeof(buf), "THEME");
+	ok1(!buf[0]);
+
+	diag("nothing is written if nothing changed");
+	unlink(filename);
+	environment_set("XCURSOR_THEME", "Adwaita");
+	environment_save();
+	ok1(!g_file_test(filename, G_FILE_TEST_EXISTS));
+
+	diag("changes keep order and comments and are written once");
+	environment_set("XCURSOR_THEME", "breeze");
+	environment_set("XKB_DEFAULT_LAYOUT", "de");
+	environment_unset("XKB_DEFAULT_VARIANT");
+	environment_set_num("XCURSOR_SIZE", 32);
+	ok1(!g_file_test(filename, G_FILE_TEST_EXISTS));
+	environment_save();
+	g_file_get_contents(filename, &contents, NULL, NULL);
+	ok1(contents && !strcmp(contents, expected));
+	g_free(contents);
+	environment_finish();
+
+	diag("re-read written file");
+	environment_init(filename);
+	environment_get(buf, sizeof(buf), "MY_XCURSOR_THEME");
+	ok1(!strcmp(buf, "mine"));
+	environment_get(buf, sizeof(buf), "XCURSOR_SIZE");
+	ok1(!strcmp(buf, "32"));
+	environment_finish();
+
+	unlink(filename);
+	rmdir(dir);
+	g_free(filename);
+	return exit_status();
+}
@@ -0,0 +1,67 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../kvfile.h"
+
+static const char original[] =
+	"! overrides\n"
+	"border.width:   2\n"
+	"# keep this\n"
+	"window.active.title.bg.color:#ff0000\n"
+	"padding.height: 3\n";
+
+static const char expected[] =
+	"! overrides\n"
+	"border.width: 4\n"
+	"# keep this\n"
+	"padding.height: 3\n"
+	"window.inactive.title.bg.color: #00ff00\n";
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1006-kvfile_XXXXXX";
+	struct kvfile kvfile;
+	char *contents = NULL;
+
+	plan(7);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	char *filename = g_build_filename(dir, "labwc", "themerc-override", NULL);
+
+	diag("missing file is empty and not created until something is set");
+	kvfile_init(&kvfile, filename, ':');
+	ok1(!kvfile_get(&kvfile, "border.width"));
+	ok1(kvfile_save(&kvfile) && !g_file_test(filename, G_FILE_TEST_EXISTS));
+	kvfile_finish(&kvfile);
+
+	diag("':' delimiter with '!' comments");
+	char *parent = g_path_get_dirname(filename);
+	g_mkdir_with_parents(parent, 0755);
+	g_file_set_contents(filename, original, -1, NULL);
+	kvfile_init(&kvfile, filename, ':');
+	ok1(!strcmp(kvfile_get(&kvfile, "border.width"), "2"));
+	ok1(!strcmp(kvfile_get(&kvfile, "window.active.title.bg.color"), "#ff0000"));
+	ok1(!kvfile_get(&kvfile, "! overrides"));
+
+	diag("only changed lines are rewritten");
+	kvfile_set(&kvfile, "border.width", "4");
+	kvfile_set(&kvfile, "padding.height", "3");
+	kvfile_unset(&kvfile, "window.active.title.bg.color");
+	kvfile_set(&kvfile, "window.inactive.title.bg.color", "#00ff00");
+	ok1(kvfile_save(&kvfile));
+	g_file_get_contents(filename, &contents, NULL, NULL);
+	ok1(contents && !strcmp(contents, expected));
+	g_free(contents);
+	kvfile_finish(&kvfile);
+
+	unlink(filename);
+	rmdir(parent);
+	rmdir(dir);
+	g_free(parent);
+	g_free(filename);
+	return exit_status();
+}
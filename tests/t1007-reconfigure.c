@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../reconfigure.h"
+
+static int fds[2];
+
+static void
+handle_sighup(int sig)
+{
+	char c = 'H';
+	if (write(fds[1], &c, 1) != 1) {
+		_exit(EXIT_FAILURE);
+	}
+}
+
+/* stand-in for labwc which reports each SIGHUP on a pipe */
+static pid_t
+spawn_compositor(void)
+{
+	int ready[2];
+	if (pipe(fds) || pipe(ready))
+		exit(EXIT_FAILURE);
+	pid_t pid = fork();
+	if (pid < 0)
+		exit(EXIT_FAILURE);
+	if (!pid) {
+		struct sigaction sa = { .sa_handler = handle_sighup };
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGHUP, &sa, NULL);
+		close(fds[0]);
+		close(ready[0]);
+		if (write(ready[1], "R", 1) != 1)
+			_exit(EXIT_FAILURE);
+		for (;;)
+			pause();
+	}
+	close(fds[1]);
+	close(ready[1]);
+	char c;
+	if (read(ready[0], &c, 1) != 1)
+		exit(EXIT_FAILURE);
+	close(ready[0]);
+	return pid;
+}
+
+int main(int argc, char **argv)
+{
+	char buf[32];
+	char c = 0;
+
+	plan(6);
+
+	diag("fall back to labwc -r without a usable LABWC_PID");
+	g_unsetenv("LABWC_PID");
+	ok1(!reconfigure_labwc());
+	g_setenv("LABWC_PID", "12abc", TRUE);
+	ok1(!reconfigure_labwc());
+	snprintf(buf, sizeof(buf), "%d", getpid());
+	g_setenv("LABWC_PID", buf, TRUE);
+	ok1(!reconfigure_labwc());
+
+	diag("signal the compositor directly");
+	pid_t pid = spawn_compositor();
+	snprintf(buf, sizeof(buf), "%d", pid);
+	g_setenv("LABWC_PID", buf, TRUE);
+	ok1(reconfigure_labwc());
+	ok1(read(fds[0], &c, 1) == 1 && c == 'H');
+
+	diag("fall back if the compositor has gone");
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+	ok1(!reconfigure_labwc());
+
+	close(fds[0]);
+	return exit_status();
+}
@@ -0,0 +1,150 @@
+#define _GNU_SOURCE
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../apply.h"
+#include "../environment.h"
+#include "../kvfile.h"
+#include "../xml.h"
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define CYCLES 10000
+#define WARMUP 100
+/*
+ * glib and libxml2 may still grow an internal cache once after warming up,
+ * but leaking even the smallest block per cycle is far more than this
+ */
+#define HEAP_SLACK 4096
+
+static const char rcxml[] =
+	"<?xml version=\"1.0\"?>\n"
+	"<labwc_config>\n"
+	"  <core>\n"
+	"    <gap>0</gap>\n"
+	"  </core>\n"
+	"  <theme>\n"
+	"    <name>Numix</name>\n"
+	"  </theme>\n"
+	"</labwc_config>\n";
+
+static const char *keys[] = {
+	"/labwc_config/core/gap",
+	"/labwc_config/theme/name",
+	"XCURSOR_SIZE",
+	"XKB_DEFAULT_VARIANT",
+	"border.width",
+};
+
+static const enum backend backends[] = {
+	BACKEND_XML,
+	BACKEND_XML,
+	BACKEND_ENVIRONMENT,
+	BACKEND_ENVIRONMENT,
+	BACKEND_THEMERC_OVERRIDE,
+};
+
+#define NR_KEYS G_N_ELEMENTS(keys)
+
+/*
+ * The values the widgets would have in the nth cycle, NULL meaning unset.
+ * This stands in for widget_value() in update.c, which hands over newly
+ * allocated strings in the same way but needs GTK, so is not covered here.
+ */
+static char *
+value(int n, size_t key)
+{
+	switch (key) {
+	case 0:
+		return g_strdup_printf("%d", n % 10);
+	case 1:
+		return g_strdup(n & 1 ? "Numix" : "Adwaita");
+	case 2:
+		return g_strdup_printf("%d", 24 + n % 3 * 8);
+	case 3:
+	case 4:
+		return n & 1 ? g_strdup_printf("%d", n % 4) : NULL;
+	}
+	return NULL;
+}
+
+static void
+cycle(struct kvfile *override, char **snapshot, int n)
+{
+	struct apply apply = { .themerc_override = override };
+	for (size_t i = 0; i < NR_KEYS; i++) {
+		apply_value(&apply, backends[i], keys[i], false, &snapshot[i], value(n, i));
+	}
+	if (apply.changed[BACKEND_XML]) {
+		xml_save();
+	}
+	if (apply.changed[BACKEND_ENVIRONMENT]) {
+		environment_save();
+	}
+	if (apply.changed[BACKEND_THEMERC_OVERRIDE]) {
+		kvfile_save(override);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1008-apply_XXXXXX";
+	char *snapshot[NR_KEYS] = { 0 };
+	struct kvfile override;
+
+	plan(5);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	char *rcxml_filename = g_build_filename(dir, "rc.xml", NULL);
+	char *environment_filename = g_build_filename(dir, "environment", NULL);
+	char *override_filename = g_build_filename(dir, "themerc-override", NULL);
+	g_file_set_contents(rcxml_filename, rcxml, -1, NULL);
+	xml_init(rcxml_filename);
+	environment_init(environment_filename);
+	kvfile_init(&override, override_filename, ':');
+
+	diag("only changed values are written");
+	struct apply apply = { .themerc_override = &override };
+	snapshot[0] = g_strdup("0");
+	ok1(!apply_value(&apply, BACKEND_XML, keys[0], false, &snapshot[0], g_strdup("0")));
+	ok1(!apply.changed[BACKEND_XML]);
+	ok1(apply_value(&apply, BACKEND_XML, keys[0], false, &snapshot[0], g_strdup("5")));
+	ok1(apply.changed[BACKEND_XML] && !strcmp(xml_get((char *)keys[0]), "5"));
+
+	diag("no heap growth over %d update cycles", CYCLES);
+	for (int n = 0; n < WARMUP; n++) {
+		cycle(&override, snapshot, n);
+	}
+#ifdef __GLIBC__
+	struct mallinfo2 before = mallinfo2();
+#endif
+	for (int n = WARMUP; n < WARMUP + CYCLES; n++) {
+		cycle(&override, snapshot, n);
+	}
+#ifdef __GLIBC__
+	struct mallinfo2 after = mallinfo2();
+	ok(after.uordblks <= before.uordblks + HEAP_SLACK, "heap grew by %ld bytes",
+		(long)(after.uordblks - before.uordblks));
+#else
+	ok(1, "# skip mallinfo2() is glibc only");
+#endif
+
+	for (size_t i = 0; i < NR_KEYS; i++) {
+		g_free(snapshot[i]);
+	}
+	kvfile_finish(&override);
+	environment_finish();
+	xml_finish();
+	unlink(rcxml_filename);
+	unlink(environment_filename);
+	unlink(override_filename);
+	rmdir(dir);
+	g_free(rcxml_filename);
+	g_free(environment_filename);
+	g_free(override_filename);
+	return exit_status();
+}
@@ -0,0 +1,59 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../trace.h"
+
+static gpointer
+worker(gpointer data)
+{
+	gint64 *start = data;
+	trace_end(*start, "worker \"quoted\"");
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1009-trace_XXXXXX";
+	char *contents = NULL;
+
+	plan(7);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	char *filename = g_build_filename(dir, "trace.json", NULL);
+
+	diag("nothing is recorded unless LABWC_TWEAKS_TRACE is set");
+	g_unsetenv("LABWC_TWEAKS_TRACE");
+	trace_init();
+	ok1(!trace_begin());
+	trace_end(trace_begin(), "ignored");
+	trace_finish();
+	ok1(!g_file_test(filename, G_FILE_TEST_EXISTS));
+
+	diag("spans are written as complete events");
+	g_setenv("LABWC_TWEAKS_TRACE", filename, TRUE);
+	trace_init();
+	gint64 start = trace_begin();
+	ok1(start > 0);
+	g_usleep(1000);
+	trace_end(start, "startup");
+	GThread *thread = g_thread_new("worker", worker, &start);
+	g_thread_join(thread);
+	trace_finish();
+
+	g_file_get_contents(filename, &contents, NULL, NULL);
+	ok1(contents && g_str_has_prefix(contents, "{\"traceEvents\":["));
+	ok1(contents && strstr(contents, "{\"name\":\"startup\",\"ph\":\"X\""));
+	ok1(contents && strstr(contents, "\"tid\":1}"));
+	ok1(contents && strstr(contents, "{\"name\":\"worker \\\"quoted\\\"\"")
+		&& strstr(contents, "\"tid\":2}"));
+	g_free(contents);
+
+	unlink(filename);
+	rmdir(dir);
+	g_free(filename);
+	return exit_status();
+}
@@ -0,0 +1,85 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../watchdog.h"
+
+static gboolean
+block(gpointer data)
+{
+	const char *previous = watchdog_begin("sleeping");
+	g_usleep(300 * 1000);
+	watchdog_end(previous);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+quit(gpointer data)
+{
+	g_main_loop_quit(data);
+	return G_SOURCE_REMOVE;
+}
+
+static guint
+total(guint counts[WATCHDOG_NR_BUCKETS])
+{
+	guint n = 0;
+	for (int i = 0; i < WATCHDOG_NR_BUCKETS; i++)
+		n += counts[i];
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	char filename[] = "/tmp/t1010-watchdog_XXXXXX";
+	guint counts[WATCHDOG_NR_BUCKETS];
+	int upper_ms[WATCHDOG_NR_BUCKETS];
+	char *log = NULL;
+
+	plan(6);
+
+	diag("nothing is watched unless asked to");
+	g_unsetenv("LABWC_TWEAKS_WATCHDOG");
+	watchdog_init(0);
+	watchdog_end(watchdog_begin("idle"));
+	watchdog_get_histogram(counts, NULL);
+	ok1(total(counts) == 0);
+	watchdog_finish();
+
+	/* collect warnings in a file */
+	int fd = mkstemp(filename);
+	int saved_stderr = dup(STDERR_FILENO);
+	if (fd < 0 || saved_stderr < 0 || dup2(fd, STDERR_FILENO) < 0)
+		exit(EXIT_FAILURE);
+
+	GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+	watchdog_init(50);
+	g_timeout_add(100, block, NULL);
+	g_timeout_add(600, quit, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+	watchdog_get_histogram(counts, upper_ms);
+	watchdog_finish();
+
+	fflush(stderr);
+	dup2(saved_stderr, STDERR_FILENO);
+	close(saved_stderr);
+	close(fd);
+
+	diag("a 300ms stall is counted once, in the 200-400ms bucket");
+	ok1(total(counts) == 1);
+	ok1(upper_ms[1] == 200 && upper_ms[2] == 400 && counts[2] == 1);
+	ok1(upper_ms[WATCHDOG_NR_BUCKETS - 1] == 0);
+
+	diag("and blamed on the operation in flight");
+	g_file_get_contents(filename, &log, NULL, NULL);
+	ok1(log && strstr(log, "main loop stalled in sleeping, running for"));
+	ok1(log && strstr(log, "ms in sleeping\n"));
+	g_free(log);
+
+	unlink(filename);
+	return exit_status();
+}
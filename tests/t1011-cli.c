@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../cli.h"
+
+static char output[4096];
+
+/* run cli_run() on the NULL-terminated arguments, capturing stdout in output */
+static int
+run(const char *arg, ...)
+{
+	char *argv[16] = { "labwc-tweaks-gtk" };
+	int argc = 1;
+	va_list ap;
+
+	va_start(ap, arg);
+	for (; arg && argc < 15; arg = va_arg(ap, const char *)) {
+		argv[argc++] = (char *)arg;
+	}
+	va_end(ap);
+
+	FILE *file = tmpfile();
+	if (!file)
+		exit(EXIT_FAILURE);
+	fflush(stdout);
+	int saved = dup(STDOUT_FILENO);
+	dup2(fileno(file), STDOUT_FILENO);
+	int status = cli_run(argc, argv);
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+
+	rewind(file);
+	size_t len = fread(output, 1, sizeof(output) - 1, file);
+	output[len] = '\0';
+	fclose(file);
+	return status;
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1011-cli_XXXXXX";
+	char *contents = NULL;
+
+	plan(15);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	g_setenv("HOME", dir, TRUE);
+	char *data_home = g_build_filename(dir, "share", NULL);
+	g_setenv("XDG_DATA_HOME", data_home, TRUE);
+	char *labwc_dir = g_build_filename(dir, ".config", "labwc", NULL);
+	char *rcxml = g_build_filename(labwc_dir, "rc.xml", NULL);
+	char *environment = g_build_filename(labwc_dir, "environment", NULL);
+	char *theme_dir = g_build_filename(data_home, "themes", "Foo", "openbox-3", NULL);
+	char *themerc = g_build_filename(theme_dir, "themerc", NULL);
+
+	diag("only the headless options bypass the GUI");
+	char *gui_argv[] = { "labwc-tweaks-gtk", "--debounce-ms", "100", NULL };
+	char *cli_argv[] = { "labwc-tweaks-gtk", "--get=/labwc_config/theme/name", NULL };
+	ok1(!cli_wanted(3, gui_argv));
+	ok1(cli_wanted(2, cli_argv));
+
+	diag("rc.xml is created with the value set, which is then read back");
+	ok1(run("--set", "/labwc_config/theme/name=Foo", "--get", "/labwc_config/theme/name", NULL) == EXIT_SUCCESS);
+	ok1(!strcmp(output, "Foo\n"));
+	g_file_get_contents(rcxml, &contents, NULL, NULL);
+	ok1(contents && strstr(contents, "<name>Foo</name>"));
+	g_free(contents);
+
+	diag("environment variables are set, left alone if unchanged, and unset");
+	run("--set=environment/XCURSOR_SIZE=32", NULL);
+	ok1(g_file_get_contents(environment, &contents, NULL, NULL) && !strcmp(contents, "XCURSOR_SIZE=32\n"));
+	g_free(contents);
+	/* files are replaced by renaming a new one into place when written */
+	struct stat before, after;
+	stat(environment, &before);
+	run("--set", "environment/XCURSOR_SIZE=32", NULL);
+	stat(environment, &after);
+	ok1(before.st_ino == after.st_ino);
+	run("--set", "environment/XCURSOR_SIZE=", NULL);
+	ok1(g_file_get_contents(environment, &contents, NULL, NULL) && !*contents);
+	g_free(contents);
+
+	diag("files which exist but cannot be read are not written over");
+	char *themerc_override = g_build_filename(labwc_dir, "themerc-override", NULL);
+	g_mkdir_with_parents(themerc_override, 0755);
+	ok1(run("--set", "themerc-override/border.width=2", NULL) == EXIT_FAILURE);
+	ok1(g_file_test(themerc_override, G_FILE_TEST_IS_DIR));
+	rmdir(themerc_override);
+	g_free(themerc_override);
+
+	diag("missing values and bad arguments fail");
+	ok1(run("--get", "environment/XCURSOR_SIZE", NULL) == EXIT_FAILURE && !*output);
+	ok1(run("--get", "nowhere/key", NULL) == EXIT_FAILURE);
+	ok1(run("--get", NULL) == EXIT_FAILURE);
+
+	diag("themes are found as on the pages");
+	g_mkdir_with_parents(theme_dir, 0755);
+	g_file_set_contents(themerc, "", -1, NULL);
+	ok1(run("--list-themes", "openbox", NULL) == EXIT_SUCCESS && strstr(output, "Foo\n"));
+	ok1(run("--list-themes", "wallpaper", NULL) == EXIT_FAILURE);
+
+	unlink(themerc);
+	rmdir(theme_dir);
+	*strrchr(theme_dir, '/') = '\0';
+	rmdir(theme_dir);
+	*strrchr(theme_dir, '/') = '\0';
+	rmdir(theme_dir);
+	rmdir(data_home);
+	unlink(rcxml);
+	unlink(environment);
+	rmdir(labwc_dir);
+	*strrchr(labwc_dir, '/') = '\0';
+	rmdir(labwc_dir);
+	rmdir(dir);
+	g_free(themerc);
+	g_free(theme_dir);
+	g_free(environment);
+	g_free(rcxml);
+	g_free(labwc_dir);
+	g_free(data_home);
+	return exit_status();
+}
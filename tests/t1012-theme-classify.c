@@ -0,0 +1,88 @@
+#define _POSIX_C_SOURCE 200809L
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap.h"
+#include "../theme.h"
+
+static char dir[] = "/tmp/t1012-theme-classify_XXXXXX";
+
+/* create @file below the theme directory @theme, or just the directory if NULL */
+static void
+add(const char *theme, const char *file, const char *contents)
+{
+	char *path = g_build_filename(dir, theme, file, NULL);
+	char *parent = file ? g_path_get_dirname(path) : g_strdup(path);
+	g_mkdir_with_parents(parent, 0755);
+	if (file) {
+		g_file_set_contents(path, contents, -1, NULL);
+	}
+	g_free(parent);
+	g_free(path);
+}
+
+static unsigned int
+classify(const char *theme)
+{
+	char *path = g_build_filename(dir, theme, NULL);
+	unsigned int kinds = theme_classify(path);
+	g_free(path);
+	return kinds;
+}
+
+static void
+remove_all(const char *path)
+{
+	GDir *gdir = g_dir_open(path, 0, NULL);
+	if (gdir) {
+		const char *name;
+		while ((name = g_dir_read_name(gdir))) {
+			char *child = g_build_filename(path, name, NULL);
+			remove_all(child);
+			g_free(child);
+		}
+		g_dir_close(gdir);
+	}
+	g_remove(path);
+}
+
+int main(int argc, char **argv)
+{
+	plan(9);
+
+	if (!mkdtemp(dir))
+		exit(EXIT_FAILURE);
+
+	add("Openbox", "openbox-3/themerc", "");
+	add("Gtk", "gtk-3.0/gtk.css", "");
+	add("Gtk", "gtk-2.0/gtkrc", "");
+	add("Index", "index.theme", "[Icon Theme]\nName=Index\nDirectories=apps\n");
+	add("Index", "apps/foo.png", "");
+	add("Sized", "48x48@2/apps/foo.png", "");
+	add("Scalable", "scalable/apps/foo.svg", "");
+	add("Cursor", "cursors/left_ptr", "");
+	add("Cursor", "index.theme", "[Icon Theme]\nName=Cursor\n");
+	add("Gtk2", "gtk-2.0/gtkrc", "");
+	add("Gtk2", "index.theme", "[Desktop Entry]\nType=X-GNOME-Metatheme\n");
+	add("Xfwm4", "xfwm4/themerc", "");
+	add("Empty", NULL, NULL);
+
+	diag("themes are classified by what they contain");
+	ok1(classify("Openbox") == THEME_KIND_OPENBOX);
+	ok1(classify("Gtk") == THEME_KIND_GTK);
+	ok1(classify("Cursor") == THEME_KIND_CURSOR);
+
+	diag("icon themes need an index.theme or size directories");
+	ok1(classify("Index") == THEME_KIND_ICON);
+	ok1(classify("Sized") == THEME_KIND_ICON);
+	ok1(classify("Scalable") == THEME_KIND_ICON);
+
+	diag("directories of other desktops' themes are not icon themes");
+	ok1(classify("Gtk2") == 0);
+	ok1(classify("Xfwm4") == 0);
+	ok1(classify("Empty") == 0);
+
+	remove_all(dir);
+	return exit_status();
+}
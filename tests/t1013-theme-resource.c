@@ -0,0 +1,67 @@
+#define _POSIX_C_SOURCE 200809L
+#include <gio/gio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tap.h"
+#include "../theme-resource.h"
+
+#define CONTAINED "/org/example/theme/3.0/gtk-contained.css"
+
+/* argv[1] is a gtk.gresource built from t1013-theme-resource.gresource.xml */
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/t1013-theme-resource_XXXXXX";
+	GError *err = NULL;
+	char *contents = NULL;
+	gsize len = 0;
+
+	plan(8);
+
+	if (argc < 2 || !mkdtemp(dir))
+		exit(EXIT_FAILURE);
+	char *gtk_dir = g_build_filename(dir, "gtk-3.0", NULL);
+	char *css = g_build_filename(gtk_dir, "gtk.css", NULL);
+	char *gresource = g_build_filename(gtk_dir, "gtk.gresource", NULL);
+	g_mkdir_with_parents(gtk_dir, 0755);
+	g_file_set_contents(css, "@import url(\"resource://" CONTAINED "\");\n", -1, NULL);
+
+	diag("the gtk.gresource is looked for next to gtk.css");
+	char *filename = theme_resource_filename(css);
+	ok1(!strcmp(filename, gresource));
+	g_free(filename);
+
+	diag("themes with plain stylesheets have no resource, which is no error");
+	ok1(!theme_resource_load(css, &err) && !err);
+
+	diag("a broken gtk.gresource is an error");
+	g_file_set_contents(gresource, "not a gresource", -1, NULL);
+	ok1(!theme_resource_load(css, &err) && err);
+	g_clear_error(&err);
+
+	diag("the stylesheets gtk.css imports resolve once the resource is registered");
+	g_file_get_contents(argv[1], &contents, &len, NULL);
+	g_file_set_contents(gresource, contents, len, NULL);
+	g_free(contents);
+	GResource *resource = theme_resource_load(css, &err);
+	ok1(resource && !err);
+	ok1(!g_resources_get_info(CONTAINED, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL, NULL, NULL));
+	g_resources_register(resource);
+	GBytes *bytes = g_resources_lookup_data(CONTAINED, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL);
+	ok1(bytes != NULL);
+	ok1(bytes && g_strstr_len(g_bytes_get_data(bytes, NULL), g_bytes_get_size(bytes), "#123456"));
+	if (bytes)
+		g_bytes_unref(bytes);
+	g_resources_unregister(resource);
+	g_resource_unref(resource);
+	ok1(!g_resources_get_info(CONTAINED, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL, NULL, NULL));
+
+	unlink(gresource);
+	unlink(css);
+	rmdir(gtk_dir);
+	rmdir(dir);
+	g_free(gresource);
+	g_free(css);
+	g_free(gtk_dir);
+	return exit_status();
+}
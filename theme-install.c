@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _XOPEN_SOURCE 700
+#include <archive.h>
+#include <archive_entry.h>
+#include <ftw.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include "theme-install.h"
+
+#define BLOCK_SIZE (64 * 1024)
+
+static int
+remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static void
+remove_tree(const char *path)
+{
+	nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/* refuse absolute paths and '..' so nothing is written outside the staging dir */
+static bool
+is_safe_path(const char *path)
+{
+	if (!path || !*path || path[0] == '/') {
+		return false;
+	}
+	char **components = g_strsplit(path, "/", -1);
+	bool safe = true;
+	for (char **s = components; *s; s++) {
+		if (!strcmp(*s, "..")) {
+			safe = false;
+			break;
+		}
+	}
+	g_strfreev(components);
+	return safe;
+}
+
+static int
+copy_data(struct archive *in, struct archive *out)
+{
+	const void *buf;
+	size_t size;
+	int64_t offset;
+
+	for (;;) {
+		int ret = archive_read_data_block(in, &buf, &size, &offset);
+		if (ret == ARCHIVE_EOF) {
+			return ARCHIVE_OK;
+		}
+		if (ret < ARCHIVE_OK) {
+			return ret;
+		}
+		ret = archive_write_data_block(out, buf, size, offset);
+		if (ret < ARCHIVE_OK) {
+			return ret;
+		}
+	}
+}
+
+static gboolean
+extract(const char *filename, const char *dest, GError **err)
+{
+	gboolean ok = FALSE;
+	struct archive_entry *entry;
+	struct archive *in = archive_read_new();
+	struct archive *out = archive_write_disk_new();
+
+	archive_read_support_filter_all(in);
+	archive_read_support_format_tar(in);
+	archive_write_disk_set_options(out, ARCHIVE_EXTRACT_TIME
+		| ARCHIVE_EXTRACT_SECURE_NODOTDOT | ARCHIVE_EXTRACT_SECURE_SYMLINKS);
+	archive_write_disk_set_standard_lookup(out);
+
+	if (archive_read_open_filename(in, filename, BLOCK_SIZE) != ARCHIVE_OK) {
+		g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED, "%s", archive_error_string(in));
+		goto out;
+	}
+
+	int ret;
+	while ((ret = archive_read_next_header(in, &entry)) == ARCHIVE_OK) {
+		mode_t type = archive_entry_filetype(entry);
+		if (type != AE_IFREG && type != AE_IFDIR && type != AE_IFLNK) {
+			continue;
+		}
+		const char *hardlink = archive_entry_hardlink(entry);
+		if (!is_safe_path(archive_entry_pathname(entry))
+				|| (hardlink && !is_safe_path(hardlink))) {
+			fprintf(stderr, "warn: skipping '%s'\n", archive_entry_pathname(entry));
+			continue;
+		}
+
+		char *path = g_build_filename(dest, archive_entry_pathname(entry), NULL);
+		archive_entry_set_pathname(entry, path);
+		g_free(path);
+		if (hardlink) {
+			path = g_build_filename(dest, hardlink, NULL);
+			archive_entry_set_hardlink(entry, path);
+			g_free(path);
+		}
+
+		if (archive_write_header(out, entry) < ARCHIVE_OK
+				|| (archive_entry_size(entry) > 0 && copy_data(in, out) < ARCHIVE_OK)
+				|| archive_write_finish_entry(out) < ARCHIVE_OK) {
+			g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED, "%s", archive_error_string(out));
+			goto out;
+		}
+	}
+	if (ret != ARCHIVE_EOF) {
+		g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED, "%s", archive_error_string(in));
+		goto out;
+	}
+	ok = TRUE;
+out:
+	archive_read_free(in);
+	archive_write_free(out);
+	return ok;
+}
+
+static void
+add_result(struct themes *themes, const char *dir, const char *name, const char *filename)
+{
+	char *path = filename ? g_build_filename(dir, filename, NULL) : g_strdup(dir);
+	theme_add(themes, name, path);
+	g_free(path);
+}
+
+/* move @name from @staging into themes/ or icons/ depending on what it is */
+static void
+install_dir(const char *staging, const char *name, struct theme_install_result *result, GString *errors)
+{
+	char *src = g_build_filename(staging, name, NULL);
+	char *dest_dir = NULL;
+	char *dest = NULL;
+
+	unsigned int kinds = theme_classify(src);
+	const char *subdir = NULL;
+	if (kinds & (THEME_KIND_OPENBOX | THEME_KIND_GTK)) {
+		subdir = "themes";
+	} else if (kinds & (THEME_KIND_ICON | THEME_KIND_CURSOR)) {
+		subdir = "icons";
+	} else {
+		g_string_append_printf(errors, "%s is not a theme\n", name);
+		goto out;
+	}
+
+	dest_dir = g_build_filename(g_get_user_data_dir(), subdir, NULL);
+	dest = g_build_filename(dest_dir, name, NULL);
+	if (g_mkdir_with_parents(dest_dir, 0755)) {
+		g_string_append_printf(errors, "cannot create %s\n", dest_dir);
+		goto out;
+	}
+	if (g_file_test(dest, G_FILE_TEST_EXISTS)) {
+		g_string_append_printf(errors, "%s is already installed\n", name);
+		goto out;
+	}
+	if (g_rename(src, dest)) {
+		g_string_append_printf(errors, "cannot install %s\n", name);
+		goto out;
+	}
+
+	if (kinds & THEME_KIND_OPENBOX) {
+		add_result(&result->openbox, dest, name, "openbox-3/themerc");
+	}
+	if (kinds & THEME_KIND_GTK) {
+		add_result(&result->gtk, dest, name, "gtk-3.0/gtk.css");
+	}
+	if (!(kinds & (THEME_KIND_OPENBOX | THEME_KIND_GTK))) {
+		if (kinds & THEME_KIND_ICON) {
+			add_result(&result->icon, dest, name, NULL);
+		}
+		if (kinds & THEME_KIND_CURSOR) {
+			add_result(&result->cursor, dest, name, "cursors");
+		}
+	}
+out:
+	g_free(dest);
+	g_free(dest_dir);
+	g_free(src);
+}
+
+gboolean
+theme_install(const char *filename, struct theme_install_result *result, GError **err)
+{
+	/* stage in the data dir itself so that installing is just a rename() */
+	const char *data_dir = g_get_user_data_dir();
+	if (g_mkdir_with_parents(data_dir, 0755)) {
+		g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED, "cannot create %s", data_dir);
+		return FALSE;
+	}
+	char *staging = g_build_filename(data_dir, ".labwc-tweaks-gtk-XXXXXX", NULL);
+	if (!g_mkdtemp(staging)) {
+		g_set_error(err, G_IO_ERROR, G_IO_ERROR_FAILED, "cannot create %s", staging);
+		g_free(staging);
+		return FALSE;
+	}
+
+	gboolean ok = extract(filename, staging, err);
+	if (ok) {
+		GString *errors = g_string_new(NULL);
+		GDir *dir = g_dir_open(staging, 0, NULL);
+		const char *name;
+		while (dir && (name = g_dir_read_name(dir))) {
+			install_dir(staging, name, result, errors);
+		}
+		if (dir) {
+			g_dir_close(dir);
+		}
+		if (!result->openbox.nr && !result->gtk.nr && !result->icon.nr && !result->cursor.nr) {
+			g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "%s",
+				errors->len ? errors->str : "no themes found in archive");
+			ok = FALSE;
+		} else if (errors->len) {
+			fprintf(stderr, "warn: %s", errors->str);
+		}
+		g_string_free(errors, TRUE);
+	}
+
+	remove_tree(staging);
+	g_free(staging);
+	return ok;
+}
+
+void
+theme_install_result_finish(struct theme_install_result *result)
+{
+	theme_free_vector(&result->openbox);
+	theme_free_vector(&result->gtk);
+	theme_free_vector(&result->icon);
+	theme_free_vector(&result->cursor);
+}
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef THEME_INSTALL_H
+#define THEME_INSTALL_H
+#include <glib.h>
+#include "theme.h"
+
+/* themes added by theme_install(), with paths in the form theme_find() uses */
+struct theme_install_result {
+	struct themes openbox;
+	struct themes gtk;
+	struct themes icon;
+	struct themes cursor;
+};
+
+/**
+ * theme_install - install themes from an archive
+ * @filename: .tar.gz, .tar.xz, .tar.bz2 or .obt archive
+ * @result: themes which have been installed
+ * @err: set if the archive could not be read or no theme was installed
+ *
+ * The archive is decompressed and extracted in a single streaming pass into a
+ * staging directory in $XDG_DATA_HOME, from where each top level directory is
+ * classified with theme_classify() and renamed into themes/ or icons/. This
+ * blocks, so should be run on a worker thread.
+ */
+gboolean theme_install(const char *filename, struct theme_install_result *result, GError **err);
+
+void theme_install_result_finish(struct theme_install_result *result);
+
+#endif /* THEME_INSTALL_H */
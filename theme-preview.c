@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <sys/stat.h>
+#include "state.h"
+#include "theme-preview.h"
+#include "themerc.h"
+
+#define PREVIEW_WIDTH 300
+#define PREVIEW_SPACING 8
+#define FONT_SIZE 12
+#define FONT_HEIGHT 16
+
+/* Number of previews to keep; each corner radius and theme edit is another */
+#define CACHE_SIZE 8
+
+static struct {
+	GMutex lock;
+	GHashTable *surfaces;
+	GQueue keys; /* of surfaces, most recently used first; owned by the table */
+	GCancellable *cancellable;
+} cache;
+
+struct request {
+	char *themerc;
+	int corner_radius;
+};
+
+static void
+request_free(struct request *request)
+{
+	g_free(request->themerc);
+	g_free(request);
+}
+
+static void
+set_source(cairo_t *cr, const struct themerc_color *color)
+{
+	cairo_set_source_rgba(cr, color->r, color->g, color->b, color->a);
+}
+
+static void
+rounded_top_rect(cairo_t *cr, double x, double y, double w, double h, double r)
+{
+	r = MIN(r, MIN(w / 2, h));
+	cairo_new_sub_path(cr);
+	cairo_move_to(cr, x, y + h);
+	cairo_line_to(cr, x, y + r);
+	cairo_arc(cr, x + r, y + r, r, G_PI, 3 * G_PI / 2);
+	cairo_line_to(cr, x + w - r, y);
+	cairo_arc(cr, x + w - r, y + r, r, 3 * G_PI / 2, 2 * G_PI);
+	cairo_line_to(cr, x + w, y + h);
+	cairo_close_path(cr);
+}
+
+static void
+draw_button(cairo_t *cr, const struct themerc_xbm *xbm, double x, double y)
+{
+	cairo_surface_t *mask = cairo_image_surface_create(CAIRO_FORMAT_A8, xbm->width, xbm->height);
+	unsigned char *data = cairo_image_surface_get_data(mask);
+	int stride = cairo_image_surface_get_stride(mask);
+	int row_bytes = (xbm->width + 7) / 8;
+
+	cairo_surface_flush(mask);
+	for (int j = 0; j < xbm->height; j++) {
+		for (int i = 0; i < xbm->width; i++) {
+			bool set = xbm->bits[j * row_bytes + i / 8] & (1 << (i % 8));
+			data[j * stride + i] = set ? 0xff : 0x00;
+		}
+	}
+	cairo_surface_mark_dirty(mask);
+	cairo_mask_surface(cr, mask, x, y);
+	cairo_surface_destroy(mask);
+}
+
+static void
+draw_titlebar(cairo_t *cr, const struct themerc *rc, double y, double radius, bool active)
+{
+	double bw = rc->border_width;
+	double h = FONT_HEIGHT + 2 * rc->padding_height;
+
+	/* border, then the title background inset by the border width */
+	set_source(cr, active ? &rc->active_border : &rc->inactive_border);
+	rounded_top_rect(cr, 0, y, PREVIEW_WIDTH, h + 2 * bw, radius);
+	cairo_fill(cr);
+	set_source(cr, active ? &rc->active_title_bg : &rc->inactive_title_bg);
+	rounded_top_rect(cr, bw, y + bw, PREVIEW_WIDTH - 2 * bw, h + bw, MAX(radius - bw, 0));
+	cairo_fill(cr);
+
+	/* label */
+	set_source(cr, active ? &rc->active_label_text : &rc->inactive_label_text);
+	cairo_select_font_face(cr, "sans-serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+	cairo_set_font_size(cr, FONT_SIZE);
+	cairo_move_to(cr, bw + MAX(radius, h / 2), y + bw + rc->padding_height + FONT_SIZE);
+	cairo_show_text(cr, active ? _("Active Window") : _("Inactive Window"));
+
+	/* buttons, right aligned and centered in square slots */
+	set_source(cr, active ? &rc->active_button : &rc->inactive_button);
+	double x = PREVIEW_WIDTH - bw - MAX(radius / 2, 0);
+	for (int i = THEMERC_BUTTON_NR - 1; i >= 0; i--) {
+		const struct themerc_xbm *xbm = &rc->buttons[i];
+		x -= h;
+		draw_button(cr, xbm, (int)(x + (h - xbm->width) / 2),
+			(int)(y + bw + (h - xbm->height) / 2));
+	}
+}
+
+static cairo_surface_t *
+render(const struct themerc *rc, int corner_radius)
+{
+	int titlebar_height = FONT_HEIGHT + 2 * rc->padding_height + 2 * rc->border_width;
+	int height = 2 * titlebar_height + PREVIEW_SPACING;
+	cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, PREVIEW_WIDTH, height);
+	cairo_t *cr = cairo_create(surface);
+	draw_titlebar(cr, rc, 0, corner_radius, true);
+	draw_titlebar(cr, rc, titlebar_height + PREVIEW_SPACING, corner_radius, false);
+	cairo_destroy(cr);
+	return surface;
+}
+
+static void
+render_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	struct request *request = task_data;
+	struct stat st;
+
+	if (stat(request->themerc, &st)) {
+		g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+			"cannot stat %s", request->themerc);
+		return;
+	}
+
+	char *key = g_strdup_printf("%s:%lld:%d", request->themerc,
+		(long long)st.st_mtime, request->corner_radius);
+	g_mutex_lock(&cache.lock);
+	cairo_surface_t *surface = NULL;
+	gpointer cached_key;
+	if (cache.surfaces && g_hash_table_lookup_extended(cache.surfaces, key,
+			&cached_key, (gpointer *)&surface)) {
+		cairo_surface_reference(surface);
+		g_queue_remove(&cache.keys, cached_key);
+		g_queue_push_head(&cache.keys, cached_key);
+	}
+	g_mutex_unlock(&cache.lock);
+
+	if (!surface) {
+		if (g_task_return_error_if_cancelled(task)) {
+			g_free(key);
+			return;
+		}
+		struct themerc rc;
+		themerc_parse(&rc, request->themerc);
+		surface = render(&rc, request->corner_radius);
+		g_mutex_lock(&cache.lock);
+		if (cache.surfaces && !g_hash_table_contains(cache.surfaces, key)) {
+			char *cached_key = g_strdup(key);
+			g_hash_table_insert(cache.surfaces, cached_key,
+				cairo_surface_reference(surface));
+			g_queue_push_head(&cache.keys, cached_key);
+			while (g_queue_get_length(&cache.keys) > CACHE_SIZE) {
+				g_hash_table_remove(cache.surfaces, g_queue_pop_tail(&cache.keys));
+			}
+		}
+		g_mutex_unlock(&cache.lock);
+	}
+	g_free(key);
+	g_task_return_pointer(task, surface, (GDestroyNotify)cairo_surface_destroy);
+}
+
+static void
+render_done(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	GError *err = NULL;
+	cairo_surface_t *surface = g_task_propagate_pointer(G_TASK(result), &err);
+	if (err) {
+		if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			gtk_image_clear(GTK_IMAGE(source_object));
+		}
+		g_error_free(err);
+		return;
+	}
+	gtk_image_set_from_surface(GTK_IMAGE(source_object), surface);
+	cairo_surface_destroy(surface);
+}
+
+void
+theme_preview_update(GtkWidget *image, const char *themerc, int corner_radius)
+{
+	g_mutex_lock(&cache.lock);
+	if (!cache.surfaces) {
+		cache.surfaces = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, (GDestroyNotify)cairo_surface_destroy);
+	}
+	g_mutex_unlock(&cache.lock);
+	if (cache.cancellable) {
+		g_cancellable_cancel(cache.cancellable);
+		g_clear_object(&cache.cancellable);
+	}
+	if (!themerc) {
+		gtk_image_clear(GTK_IMAGE(image));
+		return;
+	}
+
+	struct request *request = g_new0(struct request, 1);
+	request->themerc = g_strdup(themerc);
+	request->corner_radius = corner_radius;
+
+	cache.cancellable = g_cancellable_new();
+	GTask *task = g_task_new(image, cache.cancellable, render_done, NULL);
+	g_task_set_task_data(task, request, (GDestroyNotify)request_free);
+	g_task_run_in_thread(task, render_thread);
+	g_object_unref(task);
+}
+
+void
+theme_preview_finish(void)
+{
+	if (cache.cancellable) {
+		g_cancellable_cancel(cache.cancellable);
+		g_clear_object(&cache.cancellable);
+	}
+	g_mutex_lock(&cache.lock);
+	g_queue_clear(&cache.keys);
+	g_clear_pointer(&cache.surfaces, g_hash_table_destroy);
+	g_mutex_unlock(&cache.lock);
+}
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef THEME_PREVIEW_H
+#define THEME_PREVIEW_H
+#include <gtk/gtk.h>
+
+/**
+ * theme_preview_update - show titlebar preview of an openbox theme in @image
+ * @image: GtkImage to render into
+ * @themerc: path to <theme>/openbox-3/themerc, or NULL to clear the preview
+ * @corner_radius: radius of the titlebar's top corners
+ *
+ * The themerc is parsed and rendered on a worker thread. The most recently
+ * used results are cached by themerc path, modification time and corner
+ * radius, and a newer request cancels any preview still in flight.
+ */
+void theme_preview_update(GtkWidget *image, const char *themerc, int corner_radius);
+
+void theme_preview_finish(void);
+
+#endif /* THEME_PREVIEW_H */
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "theme-resource.h"
+
+char *
+theme_resource_filename(const char *css)
+{
+	char *dirname = g_path_get_dirname(css);
+	char *filename = g_build_filename(dirname, "gtk.gresource", NULL);
+	g_free(dirname);
+	return filename;
+}
+
+GResource *
+theme_resource_load(const char *css, GError **err)
+{
+	char *filename = theme_resource_filename(css);
+	GResource *resource = NULL;
+	if (g_file_test(filename, G_FILE_TEST_EXISTS)) {
+		resource = g_resource_load(filename, err);
+	}
+	g_free(filename);
+	return resource;
+}
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef THEME_RESOURCE_H
+#define THEME_RESOURCE_H
+#include <gio/gio.h>
+
+/**
+ * theme_resource_filename - path of the gtk.gresource next to @css
+ * @css: path to <theme>/gtk-3.0/gtk.css
+ * Returns a newly allocated string, whether or not the file exists.
+ */
+char *theme_resource_filename(const char *css);
+
+/**
+ * theme_resource_load - load the gtk.gresource of a gtk theme, if it has one
+ * @css: path to <theme>/gtk-3.0/gtk.css
+ * @err: set if there is a gtk.gresource which cannot be loaded
+ *
+ * Many themes ship a gtk.css which only imports resource:/// URLs. These
+ * resolve once the resource is passed to g_resources_register(), which has to
+ * stay registered for as long as the stylesheet is in use, as images are only
+ * loaded when drawn. Loading is safe on any thread.
+ * Returns NULL if there is no gtk.gresource or on error.
+ */
+GResource *theme_resource_load(const char *css, GError **err);
+
+#endif /* THEME_RESOURCE_H */
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <strings.h>
+#include "theme.h"
+#include "theme-selector.h"
+
+enum {
+	COLUMN_NAME = 0,
+	COLUMN_PATH,
+	COLUMN_NR
+};
+
+struct theme_selector {
+	GtkListStore *store;
+	GHashTable *rows; /* name -> GtkTreeIter */
+};
+
+static void
+selector_free(struct theme_selector *selector)
+{
+	g_hash_table_destroy(selector->rows);
+	g_object_unref(selector->store);
+	g_free(selector);
+}
+
+static struct theme_selector *
+selector_from_widget(GtkWidget *widget)
+{
+	return g_object_get_data(G_OBJECT(widget), "theme-selector");
+}
+
+GtkWidget *
+theme_selector_new(struct themes *themes)
+{
+	struct theme_selector *selector = g_new0(struct theme_selector, 1);
+	selector->store = gtk_list_store_new(COLUMN_NR, G_TYPE_STRING, G_TYPE_STRING);
+	selector->rows = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify)gtk_tree_iter_free);
+
+	/*
+	 * Fill the model before it is attached to the combobox so that no view
+	 * is listening to row-inserted. GtkListStore iters are persistent, so
+	 * they can be kept in the hash table for later lookups.
+	 */
+	for (int i = 0; i < themes->nr; ++i) {
+		struct theme *theme = themes->data + i;
+		if (g_hash_table_contains(selector->rows, theme->name)) {
+			continue;
+		}
+		GtkTreeIter iter;
+		gtk_list_store_insert_with_values(selector->store, &iter, -1,
+			COLUMN_NAME, theme->name, COLUMN_PATH, theme->path, -1);
+		g_hash_table_insert(selector->rows, g_strdup(theme->name), gtk_tree_iter_copy(&iter));
+	}
+
+	GtkWidget *combo = gtk_combo_box_new_with_model(GTK_TREE_MODEL(selector->store));
+	GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(combo), renderer, TRUE);
+	gtk_cell_layout_set_attributes(GTK_CELL_LAYOUT(combo), renderer, "text", COLUMN_NAME, NULL);
+	gtk_combo_box_set_id_column(GTK_COMBO_BOX(combo), COLUMN_PATH);
+	g_object_set_data_full(G_OBJECT(combo), "theme-selector", selector,
+		(GDestroyNotify)selector_free);
+	return combo;
+}
+
+void
+theme_selector_set_active(GtkWidget *widget, const char *name)
+{
+	struct theme_selector *selector = selector_from_widget(widget);
+	GtkTreeIter *iter = name ? g_hash_table_lookup(selector->rows, name) : NULL;
+	if (iter) {
+		gtk_combo_box_set_active_iter(GTK_COMBO_BOX(widget), iter);
+	} else {
+		gtk_combo_box_set_active(GTK_COMBO_BOX(widget), -1);
+	}
+}
+
+char *
+theme_selector_get_active(GtkWidget *widget)
+{
+	struct theme_selector *selector = selector_from_widget(widget);
+	GtkTreeIter iter;
+	char *name = NULL;
+	if (gtk_combo_box_get_active_iter(GTK_COMBO_BOX(widget), &iter)) {
+		gtk_tree_model_get(GTK_TREE_MODEL(selector->store), &iter, COLUMN_NAME, &name, -1);
+	}
+	return name;
+}
+
+void
+theme_selector_add(GtkWidget *widget, const char *name, const char *path)
+{
+	struct theme_selector *selector = selector_from_widget(widget);
+	GtkTreeModel *model = GTK_TREE_MODEL(selector->store);
+
+	GtkTreeIter *existing = g_hash_table_lookup(selector->rows, name);
+	if (existing) {
+		gtk_list_store_set(selector->store, existing, COLUMN_PATH, path, -1);
+		return;
+	}
+
+	/* binary search for the position which keeps the list sorted like theme_find() */
+	int lo = 0;
+	int hi = gtk_tree_model_iter_n_children(model, NULL);
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		GtkTreeIter iter;
+		char *mid_name = NULL;
+		gtk_tree_model_iter_nth_child(model, &iter, NULL, mid);
+		gtk_tree_model_get(model, &iter, COLUMN_NAME, &mid_name, -1);
+		if (strcasecmp(mid_name, name) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+		g_free(mid_name);
+	}
+
+	GtkTreeIter iter;
+	gtk_list_store_insert_with_values(selector->store, &iter, lo,
+		COLUMN_NAME, name, COLUMN_PATH, path, -1);
+	g_hash_table_insert(selector->rows, g_strdup(name), gtk_tree_iter_copy(&iter));
+}
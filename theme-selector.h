@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef THEME_SELECTOR_H
+#define THEME_SELECTOR_H
+#include <gtk/gtk.h>
+
+struct themes;
+
+/**
+ * theme_selector_new - create a combobox listing @themes
+ * @themes: sorted vector as produced by theme_find()
+ *
+ * The combobox is backed by a GtkListStore which is filled in bulk before it
+ * is attached to the view. A name->row hash gives constant time lookup when
+ * setting the active theme. The active id is the theme's path.
+ */
+GtkWidget *theme_selector_new(struct themes *themes);
+
+/**
+ * theme_selector_set_active - select theme by name, or nothing if not found
+ */
+void theme_selector_set_active(GtkWidget *selector, const char *name);
+
+/**
+ * theme_selector_get_active - get name of selected theme
+ * Returns a newly allocated string (or NULL) which the caller must g_free()
+ */
+char *theme_selector_get_active(GtkWidget *selector);
+
+/**
+ * theme_selector_add - insert a theme at its sorted position
+ * If a theme called @name is already listed, only its path is updated.
+ */
+void theme_selector_add(GtkWidget *selector, const char *name, const char *path);
+
+#endif /* THEME_SELECTOR_H */
@@ -10,6 +10,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "theme.h"
+#include "trace.h"
 
 static struct theme *
 grow_vector_by_one_theme(struct themes *themes)
@@ -40,6 +41,14 @@ vector_contains(struct themes *themes, const char *needle)
 	return false;
 }
 
+void
+theme_add(struct themes *themes, const char *name, const char *path)
+{
+	struct theme *theme = grow_vector_by_one_theme(themes);
+	theme->name = strdup(name);
+	theme->path = path ? strdup(path) : NULL;
+}
+
 static bool
 isdir(const char *path, const char *dirname)
 {
@@ -52,19 +61,51 @@ isdir(const char *path, const char *dirname)
 	return (!stat(buf, &st) && S_ISDIR(st.st_mode));
 }
 
+bool
+theme_is_icon_theme(const char *path)
+{
+	struct dirent *entry;
+	DIR *dp;
+	bool ret = false;
+
+	/* filter 'hicolor' as it is not a complete icon set */
+	if (strstr(path, "hicolor") != NULL) {
+		return false;
+	}
+
+	dp = opendir(path);
+	if (!dp) {
+		return false;
+	}
+
+	/*
+	 * Accept theme if directory other than 'cursors' exists.
+	 * This could be "scalable", "22x22", or whatever...
+	 */
+	while ((entry = readdir(dp))) {
+		if (entry->d_name[0] == '.' || !isdir(path, entry->d_name)) {
+			continue;
+		}
+		if (!strcmp(entry->d_name, "cursors")) {
+			continue;
+		}
+		ret = true;
+		break;
+	}
+	closedir(dp);
+	return ret;
+}
+
 /**
  * add_theme_if_icon_theme - add theme iff it is a proper icon theme
  * @themes: vector
  * @path: path to directory to search in
- * The criteria for deciding if a icon theme is a "proper icon theme" is to
- * verify the existance of a subdirectory other than "cursors"
  */
 static void
 add_theme_if_icon_theme(struct themes *themes, const char *path)
 {
 	struct dirent *entry;
 	DIR *dp;
-	struct stat st;
 
 	dp = opendir(path);
 	if (!dp) {
@@ -78,43 +119,11 @@ add_theme_if_icon_theme(struct themes *themes, const char *path)
 		char buf[4096];
 		int ret = snprintf(buf, sizeof(buf), "%s/%s", path, entry->d_name);
 		if (ret < 0) {
-			return;
-		}
-		/* filter 'hicolor' as it is not a complete icon set */
-		if (strstr(buf, "hicolor") != NULL) {
-			continue;
-		}
-
-		/* process subdirectories within the theme directory */
-		struct dirent *sub_entry;
-		DIR *sub_dp;
-		sub_dp = opendir(buf);
-		if (!sub_dp) {
-			return;
-		}
-
-		/*
-		 * Add theme if directory other than 'cursors' exists.
-		 * This could be "scalable", "22x22", or whatever...
-		 */
-		while ((sub_entry = readdir(sub_dp))) {
-			if (sub_entry->d_name[0] == '.' || !isdir(buf, sub_entry->d_name)) {
-				continue;
-			}
-			if (!strcmp(sub_entry->d_name, "cursors")) {
-				continue;
-			}
-
-			/* We've found a directory other than "cursors"! */
-			struct theme *theme = NULL;
-			if (!stat(buf, &st)) {
-				theme = grow_vector_by_one_theme(themes);
-				theme->name = strdup(entry->d_name);
-				theme->path = strdup(buf);
-			}
 			break;
 		}
-		closedir(sub_dp);
+		if (theme_is_icon_theme(buf)) {
+			theme_add(themes, entry->d_name, buf);
+		}
 	}
 	closedir(dp);
 }
@@ -138,7 +147,6 @@ process_dir(struct themes *themes, const char *path, const char *filename)
 	struct dirent *entry;
 	DIR *dp;
 	struct stat st;
-	struct theme *theme = NULL;
 
 	dp = opendir(path);
 	if (!dp) {
@@ -156,9 +164,7 @@ process_dir(struct themes *themes, const char *path, const char *filename)
 				continue;
 			}
 			if (!stat(buf, &st) && !vector_contains(themes, entry->d_name)) {
-				theme = grow_vector_by_one_theme(themes);
-				theme->name = strdup(entry->d_name);
-				theme->path = strdup(buf);
+				theme_add(themes, entry->d_name, buf);
 			}
 		}
 	}
@@ -188,8 +194,8 @@ static struct {
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
-void
-theme_find(struct themes *themes, const char *middle, const char *end)
+static void
+find(struct themes *themes, const char *middle, const char *end)
 {
 	char path[4096];
 	int ret;
@@ -233,14 +239,117 @@ theme_find(struct themes *themes, const char *middle, const char *end)
 	 * theme dir exists. In this case we add it manually.
 	 */
 	if (!vector_contains(themes, "Adwaita")) {
-		struct theme *theme = grow_vector_by_one_theme(themes);
-		theme->name = strdup("Adwaita");
-		theme->path = NULL;
+		theme_add(themes, "Adwaita", NULL);
 	}
 
 	qsort(themes->data, themes->nr, sizeof(struct theme), compare);
 }
 
+void
+theme_find(struct themes *themes, const char *middle, const char *end)
+{
+	gint64 start = trace_begin();
+	find(themes, middle, end);
+	if (start) {
+		char name[256];
+		snprintf(name, sizeof(name), "theme_find %s", end ? end : middle);
+		trace_end(start, name);
+	}
+}
+
+static bool
+exists(const char *path, const char *filename)
+{
+	char buf[4096];
+	int ret = snprintf(buf, sizeof(buf), "%s/%s", path, filename);
+	if (ret < 0) {
+		return false;
+	}
+	struct stat st;
+	return !stat(buf, &st);
+}
+
+/* as named in the Directories key of index.theme: 48x48, 48x48@2, scalable... */
+static bool
+is_size_dir(const char *name)
+{
+	unsigned int width, height, scale;
+	char end;
+	if (!strcmp(name, "scalable") || !strcmp(name, "symbolic")) {
+		return true;
+	}
+	return sscanf(name, "%ux%u%c", &width, &height, &end) == 2
+		|| sscanf(name, "%ux%u@%u%c", &width, &height, &scale, &end) == 3;
+}
+
+static bool
+has_icon_theme_index(const char *path)
+{
+	char buf[4096];
+	char line[256];
+	bool ret = false;
+
+	if (snprintf(buf, sizeof(buf), "%s/index.theme", path) < 0) {
+		return false;
+	}
+	FILE *file = fopen(buf, "r");
+	if (!file) {
+		return false;
+	}
+	while (fgets(line, sizeof(line), file)) {
+		if (!strncmp(line, "[Icon Theme]", strlen("[Icon Theme]"))) {
+			ret = true;
+			break;
+		}
+	}
+	fclose(file);
+	return ret;
+}
+
+static bool
+has_size_dir(const char *path)
+{
+	struct dirent *entry;
+	bool ret = false;
+	DIR *dp = opendir(path);
+	if (!dp) {
+		return false;
+	}
+	while ((entry = readdir(dp))) {
+		if (entry->d_name[0] != '.' && is_size_dir(entry->d_name)
+				&& isdir(path, entry->d_name)) {
+			ret = true;
+			break;
+		}
+	}
+	closedir(dp);
+	return ret;
+}
+
+unsigned int
+theme_classify(const char *path)
+{
+	unsigned int kinds = 0;
+	if (exists(path, "openbox-3/themerc")) {
+		kinds |= THEME_KIND_OPENBOX;
+	}
+	if (exists(path, "gtk-3.0/gtk.css")) {
+		kinds |= THEME_KIND_GTK;
+	}
+	if (exists(path, "cursors")) {
+		kinds |= THEME_KIND_CURSOR;
+	}
+	/*
+	 * Any subdirectory is enough for theme_find(), but gtk-2.0/, metacity-1/
+	 * or xfwm4/ alone would then count as an icon theme, so an archive must
+	 * look like one as well
+	 */
+	if (theme_is_icon_theme(path) && (has_icon_theme_index(path) || has_size_dir(path))) {
+		kinds |= THEME_KIND_ICON;
+	}
+	return kinds;
+}
+
 void
 theme_free_vector(struct themes *themes)
 {
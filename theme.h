@@ -13,7 +13,30 @@ struct themes {
 	int nr, alloc;
 };
 
+enum theme_kind {
+	THEME_KIND_OPENBOX = 1 << 0,
+	THEME_KIND_GTK = 1 << 1,
+	THEME_KIND_ICON = 1 << 2,
+	THEME_KIND_CURSOR = 1 << 3,
+};
+
 void theme_find(struct themes *themes, const char *middle, const char *end);
+void theme_add(struct themes *themes, const char *name, const char *path);
+
+/**
+ * theme_is_icon_theme - check if @path is a proper icon theme
+ * The criteria for deciding if a icon theme is a "proper icon theme" is to
+ * verify the existance of a subdirectory other than "cursors"
+ */
+bool theme_is_icon_theme(const char *path);
+
+/**
+ * theme_classify - find out what kinds of theme the directory @path holds
+ * Uses the same criteria as theme_find(), except that icon themes also need an
+ * index.theme with an [Icon Theme] section or a directory such as 48x48 or
+ * scalable. Returns enum theme_kind flags, 0 if @path is no theme at all.
+ */
+unsigned int theme_classify(const char *path);
 void theme_free_vector(struct themes *themes);
 
 #endif /* THEME_H */
@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "themerc.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+enum key_type {
+	KEY_INT = 0,
+	KEY_COLOR,
+	KEY_BORDER_COLOR,
+};
+
+/*
+ * The only keys we care about. Must be kept sorted (case-insensitively) as
+ * the table is searched with bsearch().
+ */
+static const struct key {
+	const char *name;
+	enum key_type type;
+	size_t offset;
+} keys[] = {
+	{ "border.color", KEY_BORDER_COLOR, 0 },
+	{ "border.width", KEY_INT, offsetof(struct themerc, border_width) },
+	{ "padding.height", KEY_INT, offsetof(struct themerc, padding_height) },
+	{ "window.active.border.color", KEY_COLOR, offsetof(struct themerc, active_border) },
+	{ "window.active.button.unpressed.image.color", KEY_COLOR, offsetof(struct themerc, active_button) },
+	{ "window.active.label.text.color", KEY_COLOR, offsetof(struct themerc, active_label_text) },
+	{ "window.active.title.bg.color", KEY_COLOR, offsetof(struct themerc, active_title_bg) },
+	{ "window.inactive.border.color", KEY_COLOR, offsetof(struct themerc, inactive_border) },
+	{ "window.inactive.button.unpressed.image.color", KEY_COLOR, offsetof(struct themerc, inactive_button) },
+	{ "window.inactive.label.text.color", KEY_COLOR, offsetof(struct themerc, inactive_label_text) },
+	{ "window.inactive.title.bg.color", KEY_COLOR, offsetof(struct themerc, inactive_title_bg) },
+};
+
+/* openbox/labwc built-in button bitmaps, used when a theme has no xbm files */
+static const struct {
+	const char *filename;
+	unsigned char bits[6];
+} buttons[THEMERC_BUTTON_NR] = {
+	[THEMERC_BUTTON_ICONIFY] = { "iconify.xbm", { 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f } },
+	[THEMERC_BUTTON_MAX] = { "max.xbm", { 0x3f, 0x3f, 0x21, 0x21, 0x21, 0x3f } },
+	[THEMERC_BUTTON_CLOSE] = { "close.xbm", { 0x33, 0x3f, 0x1e, 0x1e, 0x3f, 0x33 } },
+};
+
+static int
+compare_key(const void *a, const void *b)
+{
+	return strcasecmp((const char *)a, ((const struct key *)b)->name);
+}
+
+static char *
+strip(char *s)
+{
+	while (isspace((unsigned char)*s)) {
+		s++;
+	}
+	char *end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1])) {
+		*--end = '\0';
+	}
+	return s;
+}
+
+static int
+hex(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	c = tolower((unsigned char)c);
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+bool
+themerc_parse_color(struct themerc_color *color, const char *s)
+{
+	if (!s || s[0] != '#') {
+		return false;
+	}
+	s++;
+	size_t len = 0;
+	while (hex(s[len]) >= 0) {
+		len++;
+	}
+	int channels[4] = { 0, 0, 0, 255 };
+	switch (len) {
+	case 3:
+		for (int i = 0; i < 3; i++) {
+			channels[i] = hex(s[i]) * 17;
+		}
+		break;
+	case 6:
+	case 8:
+		for (size_t i = 0; i < len / 2; i++) {
+			channels[i] = hex(s[2 * i]) * 16 + hex(s[2 * i + 1]);
+		}
+		break;
+	default:
+		return false;
+	}
+	color->r = channels[0] / 255.0;
+	color->g = channels[1] / 255.0;
+	color->b = channels[2] / 255.0;
+	color->a = channels[3] / 255.0;
+	return true;
+}
+
+/**
+ * parse_xbm - read an X bitmap of at most THEMERC_XBM_MAX x THEMERC_XBM_MAX
+ * Rows are stored LSB first and padded to whole bytes, just like the file.
+ */
+static bool
+parse_xbm(struct themerc_xbm *xbm, const char *filename)
+{
+	char buf[8192];
+	FILE *fp = fopen(filename, "r");
+	if (!fp) {
+		return false;
+	}
+	size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+	fclose(fp);
+	buf[len] = '\0';
+
+	char *width = strstr(buf, "_width");
+	char *height = strstr(buf, "_height");
+	char *p = strchr(buf, '{');
+	if (!width || !height || !p) {
+		return false;
+	}
+	int w = strtol(width + strlen("_width"), NULL, 10);
+	int h = strtol(height + strlen("_height"), NULL, 10);
+	if (w <= 0 || h <= 0 || w > THEMERC_XBM_MAX || h > THEMERC_XBM_MAX) {
+		return false;
+	}
+
+	size_t nr = (size_t)h * ((w + 7) / 8);
+	size_t i = 0;
+	memset(xbm->bits, 0, sizeof(xbm->bits));
+	++p;
+	while (i < nr && *p && *p != '}') {
+		char *end;
+		long byte = strtol(p, &end, 0);
+		if (end == p) {
+			p++;
+			continue;
+		}
+		xbm->bits[i++] = (unsigned char)byte;
+		p = end;
+	}
+	xbm->width = w;
+	xbm->height = h;
+	return true;
+}
+
+static void
+set_defaults(struct themerc *rc)
+{
+	memset(rc, 0, sizeof(*rc));
+	rc->border_width = 1;
+	rc->padding_height = 3;
+	themerc_parse_color(&rc->active_border, "#aaaaaa");
+	themerc_parse_color(&rc->inactive_border, "#aaaaaa");
+	themerc_parse_color(&rc->active_title_bg, "#e1dedb");
+	themerc_parse_color(&rc->inactive_title_bg, "#f6f5f4");
+	themerc_parse_color(&rc->active_label_text, "#000000");
+	themerc_parse_color(&rc->inactive_label_text, "#000000");
+	themerc_parse_color(&rc->active_button, "#000000");
+	themerc_parse_color(&rc->inactive_button, "#000000");
+	for (int i = 0; i < THEMERC_BUTTON_NR; i++) {
+		rc->buttons[i].width = 6;
+		rc->buttons[i].height = 6;
+		memcpy(rc->buttons[i].bits, buttons[i].bits, sizeof(buttons[i].bits));
+	}
+}
+
+static void
+load_buttons(struct themerc *rc, const char *filename)
+{
+	char path[4096];
+	const char *slash = strrchr(filename, '/');
+	int dirlen = slash ? (int)(slash - filename) : 1;
+	const char *dir = slash ? filename : ".";
+
+	for (int i = 0; i < THEMERC_BUTTON_NR; i++) {
+		int ret = snprintf(path, sizeof(path), "%.*s/%s", dirlen, dir, buttons[i].filename);
+		if (ret < 0 || (size_t)ret >= sizeof(path)) {
+			continue;
+		}
+		struct themerc_xbm xbm;
+		if (parse_xbm(&xbm, path)) {
+			rc->buttons[i] = xbm;
+		}
+	}
+}
+
+bool
+themerc_parse(struct themerc *rc, const char *filename)
+{
+	set_defaults(rc);
+
+	FILE *fp = fopen(filename, "r");
+	if (!fp) {
+		return false;
+	}
+
+	bool found[ARRAY_SIZE(keys)] = { 0 };
+	struct themerc_color border;
+	bool have_border = false;
+	char *line = NULL;
+	size_t len = 0;
+	while (getline(&line, &len, fp) != -1) {
+		char *s = line;
+		while (isspace((unsigned char)*s)) {
+			s++;
+		}
+		if (*s == '#' || *s == '!' || *s == '\0') {
+			continue;
+		}
+		char *value = strchr(s, ':');
+		if (!value) {
+			continue;
+		}
+		*value++ = '\0';
+		const struct key *key = bsearch(strip(s), keys, ARRAY_SIZE(keys),
+			sizeof(keys[0]), compare_key);
+		if (!key) {
+			continue;
+		}
+		value = strip(value);
+		char *field = (char *)rc + key->offset;
+		switch (key->type) {
+		case KEY_INT:
+			*(int *)field = atoi(value);
+			break;
+		case KEY_COLOR:
+			themerc_parse_color((struct themerc_color *)field, value);
+			break;
+		case KEY_BORDER_COLOR:
+			have_border = themerc_parse_color(&border, value);
+			break;
+		}
+		found[key - keys] = true;
+	}
+	free(line);
+	fclose(fp);
+
+	/* window.{active,inactive}.border.color take precedence over border.color */
+	if (have_border) {
+		for (size_t i = 0; i < ARRAY_SIZE(keys); i++) {
+			if (found[i]) {
+				continue;
+			}
+			if (keys[i].offset == offsetof(struct themerc, active_border)
+					|| keys[i].offset == offsetof(struct themerc, inactive_border)) {
+				*(struct themerc_color *)((char *)rc + keys[i].offset) = border;
+			}
+		}
+	}
+
+	load_buttons(rc, filename);
+	return true;
+}
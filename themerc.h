@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef THEMERC_H
+#define THEMERC_H
+#include <stdbool.h>
+
+#define THEMERC_XBM_MAX 32
+
+struct themerc_color {
+	double r, g, b, a;
+};
+
+struct themerc_xbm {
+	int width, height;
+	unsigned char bits[THEMERC_XBM_MAX * THEMERC_XBM_MAX / 8];
+};
+
+enum themerc_button {
+	THEMERC_BUTTON_ICONIFY = 0,
+	THEMERC_BUTTON_MAX,
+	THEMERC_BUTTON_CLOSE,
+	THEMERC_BUTTON_NR
+};
+
+struct themerc {
+	int border_width;
+	int padding_height;
+	struct themerc_color active_border;
+	struct themerc_color inactive_border;
+	struct themerc_color active_title_bg;
+	struct themerc_color inactive_title_bg;
+	struct themerc_color active_label_text;
+	struct themerc_color inactive_label_text;
+	struct themerc_color active_button;
+	struct themerc_color inactive_button;
+	struct themerc_xbm buttons[THEMERC_BUTTON_NR];
+};
+
+/**
+ * themerc_parse - read the subset of a themerc needed for a titlebar preview
+ * @rc: result; keys which are not found keep labwc's default values
+ * @filename: path to <theme>/openbox-3/themerc
+ * Button images are read from *.xbm files next to @filename.
+ * Returns false if @filename could not be opened.
+ */
+bool themerc_parse(struct themerc *rc, const char *filename);
+
+/**
+ * themerc_parse_color - parse #rgb, #rrggbb or #rrggbbaa
+ * Returns false (leaving @color untouched) on anything else
+ */
+bool themerc_parse_color(struct themerc_color *color, const char *s);
+
+#endif /* THEMERC_H */
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "thumbnail.h"
+
+/* https://specifications.freedesktop.org/thumbnail-spec/ */
+#define THUMBNAIL_SIZE_NORMAL 128
+
+struct request {
+	char *filename;
+	int size;
+};
+
+static void
+request_free(struct request *request)
+{
+	g_free(request->filename);
+	g_free(request);
+}
+
+static char *
+thumbnail_path(const char *uri)
+{
+	char *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+	char *basename = g_strconcat(md5, ".png", NULL);
+	char *path = g_build_filename(g_get_user_cache_dir(), "thumbnails", "normal", basename, NULL);
+	g_free(basename);
+	g_free(md5);
+	return path;
+}
+
+/* A thumbnail is only valid if it refers to the same uri and mtime */
+static GdkPixbuf *
+read_thumbnail(const char *path, const char *uri, const char *mtime)
+{
+	GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(path, NULL);
+	if (!pixbuf) {
+		return NULL;
+	}
+	if (g_strcmp0(gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::URI"), uri)
+			|| g_strcmp0(gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::MTime"), mtime)) {
+		g_object_unref(pixbuf);
+		return NULL;
+	}
+	return pixbuf;
+}
+
+static void
+write_thumbnail(GdkPixbuf *pixbuf, const char *path, const char *uri, const char *mtime)
+{
+	char *dir = g_path_get_dirname(path);
+	if (g_mkdir_with_parents(dir, 0700)) {
+		g_free(dir);
+		return;
+	}
+	g_free(dir);
+
+	/* write to a temporary file and rename so readers never see partial files */
+	char *tmp = g_strdup_printf("%s.%d.tmp", path, (int)getpid());
+	char *size = g_strdup_printf("%d", THUMBNAIL_SIZE_NORMAL);
+	if (gdk_pixbuf_save(pixbuf, tmp, "png", NULL,
+			"tEXt::Thumb::URI", uri,
+			"tEXt::Thumb::MTime", mtime,
+			"tEXt::Thumb::Size", size,
+			"tEXt::Software", "labwc-tweaks-gtk",
+			NULL)) {
+		g_chmod(tmp, 0600);
+		if (g_rename(tmp, path)) {
+			g_unlink(tmp);
+		}
+	} else {
+		g_unlink(tmp);
+	}
+	g_free(size);
+	g_free(tmp);
+}
+
+static GdkPixbuf *
+scale_down(GdkPixbuf *pixbuf, int size)
+{
+	int width = gdk_pixbuf_get_width(pixbuf);
+	int height = gdk_pixbuf_get_height(pixbuf);
+	if (width <= size && height <= size) {
+		return pixbuf;
+	}
+	double scale = (double)size / MAX(width, height);
+	GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pixbuf, MAX(width * scale, 1),
+		MAX(height * scale, 1), GDK_INTERP_BILINEAR);
+	g_object_unref(pixbuf);
+	return scaled;
+}
+
+static void
+load_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	struct request *request = task_data;
+	GError *err = NULL;
+	struct stat st;
+
+	if (g_stat(request->filename, &st)) {
+		g_task_return_new_error(task, G_IO_ERROR, g_io_error_from_errno(errno),
+			"cannot stat %s", request->filename);
+		return;
+	}
+	char *uri = g_filename_to_uri(request->filename, NULL, &err);
+	if (!uri) {
+		g_task_return_error(task, err);
+		return;
+	}
+	char *path = thumbnail_path(uri);
+	char *mtime = g_strdup_printf("%lld", (long long)st.st_mtime);
+
+	GdkPixbuf *pixbuf = read_thumbnail(path, uri, mtime);
+	if (!pixbuf && !g_task_return_error_if_cancelled(task)) {
+		pixbuf = gdk_pixbuf_new_from_file_at_size(request->filename,
+			THUMBNAIL_SIZE_NORMAL, THUMBNAIL_SIZE_NORMAL, &err);
+		if (pixbuf) {
+			write_thumbnail(pixbuf, path, uri, mtime);
+		} else {
+			g_task_return_error(task, err);
+		}
+	}
+	if (pixbuf) {
+		g_task_return_pointer(task, scale_down(pixbuf, request->size), g_object_unref);
+	}
+
+	g_free(mtime);
+	g_free(path);
+	g_free(uri);
+}
+
+void
+thumbnail_load_async(const char *filename, int size, GCancellable *cancellable,
+		GAsyncReadyCallback callback, gpointer user_data)
+{
+	struct request *request = g_new0(struct request, 1);
+	request->filename = g_strdup(filename);
+	request->size = size;
+
+	GTask *task = g_task_new(NULL, cancellable, callback, user_data);
+	g_task_set_task_data(task, request, (GDestroyNotify)request_free);
+	g_task_run_in_thread(task, load_thread);
+	g_object_unref(task);
+}
+
+GdkPixbuf *
+thumbnail_load_finish(GAsyncResult *result, GError **error)
+{
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gio/gio.h>
+
+/**
+ * thumbnail_load_async - load a preview of an image file off the main thread
+ * @filename: image to preview
+ * @size: maximum width and height of the resulting pixbuf (at most 128)
+ *
+ * Uses the freedesktop.org thumbnail cache: a valid 'normal' (128px) entry in
+ * $XDG_CACHE_HOME/thumbnails is used as is; otherwise the image is loaded and
+ * the thumbnail is written for next time.
+ */
+void thumbnail_load_async(const char *filename, int size, GCancellable *cancellable,
+	GAsyncReadyCallback callback, gpointer user_data);
+
+GdkPixbuf *thumbnail_load_finish(GAsyncResult *result, GError **error);
+
+#endif /* THUMBNAIL_H */
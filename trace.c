@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <unistd.h>
+#include "trace.h"
+
+struct event {
+	char *name;
+	gint64 ts;
+	gint64 dur;
+	int tid;
+};
+
+static struct {
+	char *filename;
+	GMutex mutex;
+	GArray *events;
+	int nr_threads;
+} trace;
+
+static GPrivate thread_key;
+
+/* small numbers are easier to read in the viewer than thread ids */
+static int
+thread_id(void)
+{
+	int id = GPOINTER_TO_INT(g_private_get(&thread_key));
+	if (!id) {
+		id = g_atomic_int_add(&trace.nr_threads, 1) + 1;
+		g_private_set(&thread_key, GINT_TO_POINTER(id));
+	}
+	return id;
+}
+
+void
+trace_init(void)
+{
+	const char *filename = g_getenv("LABWC_TWEAKS_TRACE");
+	if (!filename || !*filename) {
+		return;
+	}
+	trace.filename = g_strdup(filename);
+	trace.events = g_array_new(FALSE, FALSE, sizeof(struct event));
+
+	/* the thread calling trace_init() is "1" */
+	thread_id();
+}
+
+static void
+append_json_string(GString *s, const char *str)
+{
+	g_string_append_c(s, '"');
+	for (const char *p = str; *p; p++) {
+		if (*p == '"' || *p == '\\') {
+			g_string_append_c(s, '\\');
+			g_string_append_c(s, *p);
+		} else if ((unsigned char)*p < 0x20) {
+			g_string_append_printf(s, "\\u%04x", *p);
+		} else {
+			g_string_append_c(s, *p);
+		}
+	}
+	g_string_append_c(s, '"');
+}
+
+void
+trace_finish(void)
+{
+	if (!trace.filename) {
+		return;
+	}
+
+	GString *s = g_string_new("{\"traceEvents\":[\n");
+	int pid = getpid();
+	for (guint i = 0; i < trace.events->len; i++) {
+		struct event *event = &g_array_index(trace.events, struct event, i);
+		g_string_append(s, "{\"name\":");
+		append_json_string(s, event->name);
+		g_string_append_printf(s, ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+			",\"dur\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%d}%s\n",
+			event->ts, event->dur, pid, event->tid,
+			i + 1 < trace.events->len ? "," : "");
+		g_free(event->name);
+	}
+	g_string_append(s, "],\"displayTimeUnit\":\"ms\"}\n");
+
+	GError *err = NULL;
+	if (!g_file_set_contents(trace.filename, s->str, s->len, &err)) {
+		fprintf(stderr, "warn: %s\n", err->message);
+		g_error_free(err);
+	}
+	g_string_free(s, TRUE);
+	g_array_free(trace.events, TRUE);
+	g_clear_pointer(&trace.filename, g_free);
+}
+
+gint64
+trace_begin(void)
+{
+	return trace.filename ? g_get_monotonic_time() : 0;
+}
+
+void
+trace_end(gint64 start, const char *name)
+{
+	if (!start || !trace.filename) {
+		return;
+	}
+	struct event event = {
+		.name = g_strdup(name),
+		.ts = start,
+		.dur = g_get_monotonic_time() - start,
+		.tid = thread_id(),
+	};
+	g_mutex_lock(&trace.mutex);
+	g_array_append_val(trace.events, event);
+	g_mutex_unlock(&trace.mutex);
+}
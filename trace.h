@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef TRACE_H
+#define TRACE_H
+#include <glib.h>
+
+/**
+ * trace_init - start recording spans if $LABWC_TWEAKS_TRACE is set
+ * The variable names the file written by trace_finish() in the Chrome trace
+ * event format, which can be opened in chrome://tracing or ui.perfetto.dev.
+ */
+void trace_init(void);
+void trace_finish(void);
+
+/**
+ * trace_begin - start a span
+ * Returns the start time to pass to trace_end(), or 0 when not tracing.
+ */
+gint64 trace_begin(void);
+
+/**
+ * trace_end - record a span from @start until now
+ * @name: copied; spans may be ended on any thread, and on a different one
+ *	  to the one they were begun on.
+ */
+void trace_end(gint64 start, const char *name);
+
+#endif /* TRACE_H */
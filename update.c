@@ -1,100 +1,685 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "apply.h"
 #include "environment.h"
+#include "gtktheme.h"
+#include "keyboard-layouts.h"
+#include "layout-selector.h"
+#include "option-selector.h"
+#include "reconfigure.h"
 #include "state.h"
+#include "theme-selector.h"
+#include "trace.h"
 #include "update.h"
+#include "watchdog.h"
 #include "xml.h"
 
+/*
+ * The commands which follow the writing of settings are run one after the
+ * other as child processes without blocking the main loop. GSubprocess reaps
+ * them, and their progress and any errors are shown next to the buttons.
+ */
+struct step {
+	const char *status;
+	bool (*func)(void); /* if set and successful, argv is not run */
+	const char *argv[3];
+	bool optional; /* if it fails, the steps after it are still run */
+};
+
+struct pipeline {
+	struct state *state;
+	struct step steps[2];
+	int nr_steps;
+	int current;
+
+	/* before the steps are run, the changed files are saved concurrently */
+	int nr_saving;
+	GString *save_errors; /* names of the files which could not be saved */
+	GString *read_errors; /* names of the files left alone as they could not be read */
+	GString *errors; /* of the optional steps which failed, and the final one */
+	bool reconfigure;
+
+	/* the openbox theme "GTK" is to be generated from this gtk theme */
+	char *gtk_theme;
+	char *gtk_theme_filename;
+
+	gint64 start; /* for trace_end() */
+	gint64 step_start;
+};
+
+static void pipeline_run_step(struct pipeline *pipeline);
+
+/* the window may have been closed while the application is held, see update() */
+static void
+pipeline_status(struct pipeline *pipeline, const char *text)
+{
+	if (pipeline->state->window) {
+		gtk_label_set_text(GTK_LABEL(pipeline->state->widgets.update_status), text);
+	}
+}
+
+static void
+pipeline_add(struct pipeline *pipeline, const char *status, bool (*func)(void),
+		const char *command, const char *arg, bool optional)
+{
+	assert(pipeline->nr_steps < (int)G_N_ELEMENTS(pipeline->steps));
+	struct step *step = &pipeline->steps[pipeline->nr_steps++];
+	step->status = status;
+	step->func = func;
+	step->argv[0] = command;
+	step->argv[1] = arg;
+	step->argv[2] = NULL;
+	step->optional = optional;
+}
+
+static void
+pipeline_add_error(struct pipeline *pipeline, const char *error)
+{
+	if (!pipeline->errors) {
+		pipeline->errors = g_string_new(error);
+	} else {
+		g_string_append_printf(pipeline->errors, "; %s", error);
+	}
+}
+
+static void
+pipeline_done(struct pipeline *pipeline, const char *error)
+{
+	struct state *state = pipeline->state;
+
+	trace_end(pipeline->start, "update");
+	if (error) {
+		pipeline_add_error(pipeline, error);
+	}
+	if (pipeline->read_errors) {
+		char *read_error = g_strdup_printf(_("cannot read %s"), pipeline->read_errors->str);
+		pipeline_add_error(pipeline, read_error);
+		g_free(read_error);
+	}
+	if (state->window) {
+		gtk_spinner_stop(GTK_SPINNER(state->widgets.update_spinner));
+		gtk_widget_set_sensitive(state->widgets.update_button, TRUE);
+	}
+	if (pipeline->errors) {
+		fprintf(stderr, "warn: %s\n", pipeline->errors->str);
+		char *text = g_strdup_printf(_("Error: %s"), pipeline->errors->str);
+		pipeline_status(pipeline, text);
+		g_free(text);
+	} else {
+		pipeline_status(pipeline, _("Settings applied"));
+	}
+	if (pipeline->save_errors) {
+		g_string_free(pipeline->save_errors, TRUE);
+	}
+	if (pipeline->read_errors) {
+		g_string_free(pipeline->read_errors, TRUE);
+	}
+	if (pipeline->errors) {
+		g_string_free(pipeline->errors, TRUE);
+	}
+	g_free(pipeline->gtk_theme);
+	g_free(pipeline->gtk_theme_filename);
+	g_free(pipeline);
+	g_application_release(g_application_get_default());
+}
+
+/* an optional step which failed is reported once all steps have been run */
+static void
+pipeline_step_failed(struct pipeline *pipeline, const char *error)
+{
+	struct step *step = &pipeline->steps[pipeline->current];
+	if (!step->optional) {
+		pipeline_done(pipeline, error);
+		return;
+	}
+	pipeline_add_error(pipeline, error);
+	pipeline->current++;
+	pipeline_run_step(pipeline);
+}
+
 static void
-spawn_sync(char const *command)
+pipeline_step_done(GObject *source, GAsyncResult *res, gpointer data)
 {
+	GSubprocess *subprocess = G_SUBPROCESS(source);
+	struct pipeline *pipeline = data;
+	struct step *step = &pipeline->steps[pipeline->current];
+	char *stderr_buf = NULL;
+	char *error = NULL;
 	GError *err = NULL;
-	assert(command);
-	g_spawn_command_line_sync(command, NULL, NULL, NULL, &err);
-	if (err) {
-		fprintf(stderr, "warn: could not find %s\n", command);
+
+	if (!g_subprocess_communicate_utf8_finish(subprocess, res, NULL, &stderr_buf, &err)) {
+		error = g_strdup_printf("%s: %s", step->argv[0], err->message);
 		g_error_free(err);
+	} else if (!g_subprocess_get_successful(subprocess)) {
+		/* the last line written to stderr is most likely to say what went wrong */
+		char *message = stderr_buf ? g_strstrip(stderr_buf) : "";
+		char *last_line = strrchr(message, '\n');
+		last_line = last_line ? last_line + 1 : message;
+		if (*last_line) {
+			error = g_strdup_printf("%s: %s", step->argv[0], last_line);
+		} else {
+			error = g_strdup_printf(_("%s failed"), step->argv[0]);
+		}
+	}
+	g_free(stderr_buf);
+	g_object_unref(subprocess);
+	trace_end(pipeline->step_start, step->argv[0]);
+
+	if (error) {
+		pipeline_step_failed(pipeline, error);
+		g_free(error);
+		return;
+	}
+	pipeline->current++;
+	pipeline_run_step(pipeline);
+}
+
+static void
+pipeline_run_step(struct pipeline *pipeline)
+{
+	if (pipeline->current == pipeline->nr_steps) {
+		pipeline_done(pipeline, NULL);
+		return;
+	}
+	struct step *step = &pipeline->steps[pipeline->current];
+	pipeline_status(pipeline, step->status);
+	pipeline->step_start = trace_begin();
+	if (step->func && step->func()) {
+		trace_end(pipeline->step_start, step->argv[0]);
+		pipeline->current++;
+		pipeline_run_step(pipeline);
+		return;
+	}
+
+	GError *err = NULL;
+	GSubprocess *subprocess = g_subprocess_newv(step->argv,
+		G_SUBPROCESS_FLAGS_STDOUT_SILENCE | G_SUBPROCESS_FLAGS_STDERR_PIPE, &err);
+	if (!subprocess) {
+		char *error = g_strdup_printf("%s: %s", step->argv[0], err->message);
+		g_error_free(err);
+		pipeline_step_failed(pipeline, error);
+		g_free(error);
+		return;
+	}
+	g_subprocess_communicate_utf8_async(subprocess, NULL, NULL, pipeline_step_done, pipeline);
+}
+
+/* how a setting's value is read from its widget; NULL means unset */
+enum widget_type {
+	WIDGET_COMBO_TEXT = 0,
+	WIDGET_COMBO_ID,
+	WIDGET_THEME,
+	WIDGET_SPIN,
+	WIDGET_ENTRY,
+	WIDGET_LAYOUT,
+	WIDGET_VARIANT,
+	WIDGET_OPTIONS,
+	WIDGET_OVERRIDE_SPIN,
+	WIDGET_OVERRIDE_COLOR,
+};
+
+struct setting {
+	enum backend backend;
+	const char *key;
+	size_t widget; /* offset of the widget pointer in struct state */
+	enum widget_type type;
+};
+
+#define WIDGET(name) offsetof(struct state, widgets.name)
+
+static const struct setting settings[] = {
+	/* ~/.config/labwc/rc.xml */
+	{ BACKEND_XML, "/labwc_config/theme/cornerradius", WIDGET(corner_radius), WIDGET_SPIN },
+	{ BACKEND_XML, "/labwc_config/theme/name", WIDGET(openbox_theme_name), WIDGET_THEME },
+	{ BACKEND_XML, "/labwc_config/libinput/device/naturalscroll", WIDGET(natural_scroll), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/theme/dropShadows", WIDGET(drop_shadows), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/theme/titlebar/layout", WIDGET(button_layout), WIDGET_ENTRY },
+	{ BACKEND_XML, "/labwc_config/theme/titlebar/showTitle", WIDGET(show_title), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/snapping/topMaximize", WIDGET(top_max), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/placement/policy", WIDGET(placement), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/core/xwaylandPersistence", WIDGET(xwayland_persistence), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/core/allowTearing", WIDGET(allow_tearing), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/core/adaptiveSync", WIDGET(adaptive_sync), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/focus/followMouse", WIDGET(follow_mouse), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/focus/followMouseRequiresMovement", WIDGET(follow_mouse_requires_movement), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/focus/raiseOnFocus", WIDGET(raise_on_focus), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/core/gap", WIDGET(gap), WIDGET_SPIN },
+	{ BACKEND_XML, "/labwc_config/resize/cornerRange", WIDGET(corner_range), WIDGET_SPIN },
+	{ BACKEND_XML, "/labwc_config/resize/drawContents", WIDGET(draw_contents), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/resize/popupShow", WIDGET(popup_show), WIDGET_COMBO_TEXT },
+	{ BACKEND_XML, "/labwc_config/theme/fallbackIcon", WIDGET(icon_path), WIDGET_ENTRY },
+
+	/* gsettings */
+	{ BACKEND_GSETTINGS, "cursor-theme", WIDGET(cursor_theme_name), WIDGET_THEME },
+	{ BACKEND_GSETTINGS, "cursor-size", WIDGET(cursor_size), WIDGET_SPIN },
+	{ BACKEND_GSETTINGS, "gtk-theme", WIDGET(gtk_theme_name), WIDGET_THEME },
+	{ BACKEND_GSETTINGS, "icon-theme", WIDGET(icon_theme_name), WIDGET_THEME },
+	{ BACKEND_GSETTINGS, "color-scheme", WIDGET(prefer_dark), WIDGET_COMBO_TEXT },
+
+	/* ~/.config/labwc/environment */
+	{ BACKEND_ENVIRONMENT, "XCURSOR_THEME", WIDGET(cursor_theme_name), WIDGET_THEME },
+	{ BACKEND_ENVIRONMENT, "XCURSOR_SIZE", WIDGET(cursor_size), WIDGET_SPIN },
+	{ BACKEND_ENVIRONMENT, "XKB_DEFAULT_LAYOUT", WIDGET(keyboard_layout), WIDGET_LAYOUT },
+	{ BACKEND_ENVIRONMENT, "XKB_DEFAULT_VARIANT", WIDGET(keyboard_layout), WIDGET_VARIANT },
+	{ BACKEND_ENVIRONMENT, "XKB_DEFAULT_MODEL", WIDGET(keyboard_model), WIDGET_COMBO_ID },
+	{ BACKEND_ENVIRONMENT, "XKB_DEFAULT_OPTIONS", WIDGET(keyboard_options), WIDGET_OPTIONS },
+
+	/* ~/.config/labwc/themerc-override */
+	{ BACKEND_THEMERC_OVERRIDE, "border.width", WIDGET(override_border_width), WIDGET_OVERRIDE_SPIN },
+	{ BACKEND_THEMERC_OVERRIDE, "padding.height", WIDGET(override_padding_height), WIDGET_OVERRIDE_SPIN },
+	{ BACKEND_THEMERC_OVERRIDE, "window.active.title.bg.color", WIDGET(override_active_title_bg), WIDGET_OVERRIDE_COLOR },
+	{ BACKEND_THEMERC_OVERRIDE, "window.active.label.text.color", WIDGET(override_active_label_text), WIDGET_OVERRIDE_COLOR },
+	{ BACKEND_THEMERC_OVERRIDE, "window.inactive.title.bg.color", WIDGET(override_inactive_title_bg), WIDGET_OVERRIDE_COLOR },
+	{ BACKEND_THEMERC_OVERRIDE, "window.inactive.label.text.color", WIDGET(override_inactive_label_text), WIDGET_OVERRIDE_COLOR },
+};
+
+#define NR_SETTINGS G_N_ELEMENTS(settings)
+
+struct snapshot {
+	char *value; /* as loaded or last applied */
+	bool tracked; /* the widget's page has been built */
+};
+
+static GtkWidget *
+setting_widget(struct state *state, const struct setting *setting)
+{
+	return *(GtkWidget **)((char *)state + setting->widget);
+}
+
+/* returns a newly allocated string, or NULL if unset */
+static char *
+widget_value(struct state *state, const struct setting *setting)
+{
+	GtkWidget *widget = setting_widget(state, setting);
+	struct layout *layout;
+	char *value;
+	GdkRGBA rgba;
+	int alpha;
+
+	/* some widgets are not (yet) on any page */
+	if (!widget) {
+		return NULL;
 	}
+	switch (setting->type) {
+	case WIDGET_COMBO_TEXT:
+		return gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(widget));
+	case WIDGET_COMBO_ID:
+		return g_strdup(gtk_combo_box_get_active_id(GTK_COMBO_BOX(widget)));
+	case WIDGET_THEME:
+		return theme_selector_get_active(widget);
+	case WIDGET_SPIN:
+		return g_strdup_printf("%d", gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget)));
+	case WIDGET_ENTRY:
+		return g_strdup(gtk_entry_get_text(GTK_ENTRY(widget)));
+	case WIDGET_LAYOUT:
+		layout = layout_selector_get_active(widget);
+		return layout ? g_strdup(layout->lang) : NULL;
+	case WIDGET_VARIANT:
+		layout = layout_selector_get_active(widget);
+		return layout && *layout->variant ? g_strdup(layout->variant) : NULL;
+	case WIDGET_OPTIONS:
+		value = option_selector_get_active(widget);
+		if (!*value) {
+			g_clear_pointer(&value, g_free);
+		}
+		return value;
+	case WIDGET_OVERRIDE_SPIN:
+		if (!gtk_widget_get_sensitive(widget)) {
+			return NULL;
+		}
+		return g_strdup_printf("%d", gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget)));
+	case WIDGET_OVERRIDE_COLOR:
+		if (!gtk_widget_get_sensitive(widget)) {
+			return NULL;
+		}
+		gtk_color_chooser_get_rgba(GTK_COLOR_CHOOSER(widget), &rgba);
+		alpha = (int)(rgba.alpha * 255 + 0.5);
+		value = g_strdup_printf("#%02x%02x%02x", (int)(rgba.red * 255 + 0.5),
+			(int)(rgba.green * 255 + 0.5), (int)(rgba.blue * 255 + 0.5));
+		/* #rrggbbaa only when needed, so that opaque colors read as before */
+		if (alpha < 255) {
+			char *opaque = value;
+			value = g_strdup_printf("%s%02x", opaque, alpha);
+			g_free(opaque);
+		}
+		return value;
+	}
+	return NULL;
 }
 
-static const char
-*first_field(const char *s, char delim)
+static gboolean
+auto_apply(gpointer data)
 {
-	char *p = strchr(s, delim);
-	if (p) {
-		*p = '\0';
+	struct state *state = (struct state *)data;
+
+	if (!state->window) {
+		state->auto_apply_source = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	/* try again after another debounce period if the last update is running */
+	if (!gtk_widget_get_sensitive(state->widgets.update_button)) {
+		return G_SOURCE_CONTINUE;
 	}
-	return s;
+	state->auto_apply_source = 0;
+	update(NULL, state);
+	return G_SOURCE_REMOVE;
 }
 
 static void
-set_value_num(GSettings *settings, const char *key, int value)
+schedule_auto_apply(struct state *state)
 {
-	g_settings_set_value(settings, key, g_variant_new("i", value));
+	if (!gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->widgets.auto_apply))) {
+		return;
+	}
+	/* restart the debounce period on every change so that bursts are coalesced */
+	if (state->auto_apply_source) {
+		g_source_remove(state->auto_apply_source);
+	}
+	state->auto_apply_source = g_timeout_add(state->debounce_ms, auto_apply, state);
 }
 
 static void
-set_value(GSettings *settings, const char *key, const char *value)
+connect_auto_apply(struct state *state, const struct setting *setting, GtkWidget *widget)
+{
+	switch (setting->type) {
+	case WIDGET_COMBO_TEXT:
+	case WIDGET_COMBO_ID:
+	case WIDGET_THEME:
+	case WIDGET_ENTRY:
+		g_signal_connect_swapped(widget, "changed", G_CALLBACK(schedule_auto_apply), state);
+		break;
+	case WIDGET_SPIN:
+		g_signal_connect_swapped(widget, "value-changed", G_CALLBACK(schedule_auto_apply), state);
+		break;
+	case WIDGET_LAYOUT:
+	case WIDGET_VARIANT:
+		layout_selector_connect_changed(widget, G_CALLBACK(schedule_auto_apply), state);
+		break;
+	case WIDGET_OPTIONS:
+		option_selector_connect_changed(widget, G_CALLBACK(schedule_auto_apply), state);
+		break;
+	case WIDGET_OVERRIDE_SPIN:
+		g_signal_connect_swapped(widget, "value-changed", G_CALLBACK(schedule_auto_apply), state);
+		g_signal_connect_swapped(widget, "notify::sensitive", G_CALLBACK(schedule_auto_apply), state);
+		break;
+	case WIDGET_OVERRIDE_COLOR:
+		g_signal_connect_swapped(widget, "color-set", G_CALLBACK(schedule_auto_apply), state);
+		g_signal_connect_swapped(widget, "notify::sensitive", G_CALLBACK(schedule_auto_apply), state);
+		break;
+	}
+}
+
+void
+update_init(struct state *state)
+{
+	update_finish(state);
+	state->snapshot = g_new0(struct snapshot, NR_SETTINGS);
+	g_signal_connect_swapped(state->widgets.auto_apply, "toggled",
+		G_CALLBACK(schedule_auto_apply), state);
+}
+
+void
+update_add_widgets(struct state *state)
+{
+	for (size_t i = 0; i < NR_SETTINGS; i++) {
+		const struct setting *setting = &settings[i];
+		GtkWidget *widget = setting_widget(state, setting);
+		if (!widget || state->snapshot[i].tracked) {
+			continue;
+		}
+		state->snapshot[i].value = widget_value(state, setting);
+		state->snapshot[i].tracked = true;
+
+		/* some widgets back more than one setting */
+		bool seen = false;
+		for (size_t j = 0; j < i; j++) {
+			seen |= settings[j].widget == setting->widget;
+		}
+		if (!seen) {
+			connect_auto_apply(state, setting, widget);
+		}
+	}
+}
+
+void
+update_finish(struct state *state)
 {
-	if (!value) {
-		fprintf(stderr, "warn: cannot set '%s' - no value specified\n", key);
+	if (state->auto_apply_source) {
+		g_source_remove(state->auto_apply_source);
+		state->auto_apply_source = 0;
+	}
+	if (!state->snapshot) {
 		return;
 	}
-	g_settings_set_value(settings, key, g_variant_new("s", value));
+	for (size_t i = 0; i < NR_SETTINGS; i++) {
+		g_free(state->snapshot[i].value);
+	}
+	g_clear_pointer(&state->snapshot, g_free);
 }
 
-#define COMBO_TEXT(w) gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(w))
-#define SPIN_BUTTON_VAL(w) gtk_spin_button_get_value(GTK_SPIN_BUTTON(w))
-#define SPIN_BUTTON_VAL_INT(w) (int)SPIN_BUTTON_VAL(w)
-#define GTK_ENTRY_TEXT(w) gtk_entry_get_text(GTK_ENTRY(w))
+/* the files behind each backend are independent, so they are saved in parallel */
+struct save {
+	const char *name;
+	bool (*func)(struct state *state);
+};
+
+struct save_job {
+	struct pipeline *pipeline;
+	enum backend backend;
+	const struct save *save;
+};
+
+static bool
+save_xml(struct state *state)
+{
+	return xml_save();
+}
+
+static bool
+save_environment(struct state *state)
+{
+	return environment_save();
+}
+
+static bool
+save_themerc_override(struct state *state)
+{
+	return kvfile_save(&state->themerc_override);
+}
+
+static const struct save saves[BACKEND_NR] = {
+	[BACKEND_XML] = { "rc.xml", save_xml },
+	[BACKEND_ENVIRONMENT] = { "environment", save_environment },
+	[BACKEND_THEMERC_OVERRIDE] = { "themerc-override", save_themerc_override },
+};
+
+static void pipeline_saved(struct pipeline *pipeline);
+
+static void
+save_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	struct save_job *job = task_data;
+	gint64 start = trace_begin();
+	bool ret = job->save->func(job->pipeline->state);
+	char name[64];
+	snprintf(name, sizeof(name), "save %s", job->save->name);
+	trace_end(start, name);
+	g_task_return_boolean(task, ret);
+}
+
+static void
+save_done(GObject *source_object, GAsyncResult *res, gpointer data)
+{
+	struct pipeline *pipeline = data;
+	struct save_job *job = g_task_get_task_data(G_TASK(res));
+
+	/* a file which could not be saved is saved again with the next update */
+	bool saved = g_task_propagate_boolean(G_TASK(res), NULL);
+	pipeline->state->save_failed[job->backend] = !saved;
+	if (!saved) {
+		if (!pipeline->save_errors) {
+			pipeline->save_errors = g_string_new(job->save->name);
+		} else {
+			g_string_append_printf(pipeline->save_errors, ", %s", job->save->name);
+		}
+	}
+	if (!--pipeline->nr_saving) {
+		pipeline_saved(pipeline);
+	}
+}
 
 void
 update(GtkWidget *widget, gpointer data)
 {
 	struct state *state = (struct state *)data;
+	struct apply apply = {
+		.settings = state->settings,
+		.themerc_override = &state->themerc_override,
+	};
+	bool *changed = apply.changed;
+	bool gtk_theme_changed = false;
 
-	/* ~/.config/labwc/rc.xml */
-	xml_set_num("/labwc_config/theme/cornerradius", SPIN_BUTTON_VAL(state->widgets.corner_radius));
-	xml_set("/labwc_config/theme/name", COMBO_TEXT(state->widgets.openbox_theme_name));
-	xml_set("/labwc_config/libinput/device/naturalscroll", COMBO_TEXT(state->widgets.natural_scroll));
-	xml_set("/labwc_config/theme/dropShadows", COMBO_TEXT(state->widgets.drop_shadows));
-	xml_set("/labwc_config/theme/titlebar/layout", (char *)GTK_ENTRY_TEXT(state->widgets.button_layout));
-	xml_set("/labwc_config/theme/titlebar/showTitle", COMBO_TEXT(state->widgets.show_title));
-	xml_set("/labwc_config/snapping/topMaximize", COMBO_TEXT(state->widgets.top_max));
-	xml_set("/labwc_config/placement/policy", COMBO_TEXT(state->widgets.placement ));
-	xml_set("/labwc_config/core/xwaylandPersistence", COMBO_TEXT(state->widgets.xwayland_persistence));
-	xml_set("/labwc_config/core/allowTearing", COMBO_TEXT(state->widgets.allow_tearing));
-	xml_set("/labwc_config/core/adaptiveSync", COMBO_TEXT(state->widgets.adaptive_sync));
-	xml_set("/labwc_config/focus/followMouse", COMBO_TEXT(state->widgets.follow_mouse));
-	xml_set("/labwc_confog/placement/policy", COMBO_TEXT(state->widgets.follow_mouse_requires_movement));
-	xml_set("/labwc_config/focus/raiseOnFocus", COMBO_TEXT(state->widgets.raise_on_focus));
-	xml_set_num("/labwc_config/core/gap", SPIN_BUTTON_VAL(state->widgets.gap));
-        xml_set_num("/labwc_config/resize/cornerRange", SPIN_BUTTON_VAL(state->widgets.corner_range));
-	xml_set("/labwc_config/resize/drawContents", COMBO_TEXT(state->widgets.draw_contents));
-	xml_set("/labwc_config/resize/popupShow", COMBO_TEXT(state->widgets.popup_show));
-	xml_set("/labwc_config/theme/fallbackIcon", GTK_ENTRY_TEXT(state->widgets.icon_path));
-	xml_save();
+	if (!state->snapshot) {
+		return;
+	}
+	gint64 start = trace_begin();
+	const char *previous = watchdog_begin("comparing settings");
 
-	/* gsettings */
-	set_value(state->settings, "cursor-theme", COMBO_TEXT(state->widgets.cursor_theme_name));
-	set_value_num(state->settings, "cursor-size", SPIN_BUTTON_VAL_INT(state->widgets.cursor_size));
-	set_value(state->settings, "gtk-theme", COMBO_TEXT(state->widgets.gtk_theme_name));
-	set_value(state->settings, "icon-theme", COMBO_TEXT(state->widgets.icon_theme_name));
-	set_value(state->settings, "color-scheme", COMBO_TEXT(state->widgets.prefer_dark));
-	
+	/* only write what differs from the values loaded or last applied */
+	for (size_t i = 0; i < NR_SETTINGS; i++) {
+		const struct setting *setting = &settings[i];
 
-	/* ~/.config/labwc/environment */
-	environment_set("XCURSOR_THEME", COMBO_TEXT(state->widgets.cursor_theme_name));
-	environment_set_num("XCURSOR_SIZE", SPIN_BUTTON_VAL_INT(state->widgets.cursor_size));
-	environment_set("XKB_DEFAULT_LAYOUT", first_field(COMBO_TEXT(state->widgets.keyboard_layout), ' '));
+		/*
+		 * Settings on pages which have not been built are left alone, as
+		 * are files which could not be read, see config_loaded()
+		 */
+		if (!state->snapshot[i].tracked || state->unreadable[setting->backend]) {
+			continue;
+		}
+		if (!apply_value(&apply, setting->backend, setting->key,
+				setting->type == WIDGET_SPIN, &state->snapshot[i].value,
+				widget_value(state, setting))) {
+			continue;
+		}
+		if (setting->widget == WIDGET(openbox_theme_name)
+				|| setting->widget == WIDGET(gtk_theme_name)) {
+			gtk_theme_changed = true;
+		}
+	}
+
+	watchdog_end(previous);
+	trace_end(start, "apply");
 
-	if (!g_strcmp0(COMBO_TEXT(state->widgets.openbox_theme_name), "GTK")) {
-		spawn_sync("labwc-gtktheme.py");
+	/*
+	 * The snapshot already holds the values of a file which could not be
+	 * saved last time, but they are only in memory, so save it again
+	 */
+	for (int i = 0; i < BACKEND_NR; i++) {
+		changed[i] |= state->save_failed[i] && !state->unreadable[i];
 	}
 
-	/* reconfigure labwc */
-	if (!fork()) {
-		execl("/bin/sh", "/bin/sh", "-c", "labwc -r", (void *)NULL);
+	/* no further updates until this one is done */
+	gtk_widget_set_sensitive(state->widgets.update_button, FALSE);
+	gtk_spinner_start(GTK_SPINNER(state->widgets.update_spinner));
+
+	/*
+	 * dconf already writes asynchronously, and GSettings is best left to the
+	 * main thread, so only the files are saved on worker threads
+	 */
+	if (changed[BACKEND_GSETTINGS]) {
+		previous = watchdog_begin("g_settings_apply");
+		g_settings_apply(state->settings);
+		watchdog_end(previous);
+	}
+
+	struct pipeline *pipeline = g_new0(struct pipeline, 1);
+	pipeline->state = state;
+	pipeline->start = start;
+	pipeline->reconfigure = changed[BACKEND_XML] || changed[BACKEND_ENVIRONMENT]
+		|| changed[BACKEND_THEMERC_OVERRIDE];
+
+	/* the widgets are gone by the time the files are saved if the window is closed */
+	char *openbox_theme = gtk_theme_changed
+		? theme_selector_get_active(state->widgets.openbox_theme_name) : NULL;
+	if (!g_strcmp0(openbox_theme, "GTK")) {
+		pipeline->gtk_theme = theme_selector_get_active(state->widgets.gtk_theme_name);
+		pipeline->gtk_theme_filename = g_strdup(
+			gtk_combo_box_get_active_id(GTK_COMBO_BOX(state->widgets.gtk_theme_name)));
+	}
+	g_free(openbox_theme);
+
+	/* quitting only takes effect once the update is done, see pipeline_done() */
+	g_application_hold(g_application_get_default());
+
+	for (int i = 0; i < BACKEND_NR; i++) {
+		if (!state->unreadable[i]) {
+			continue;
+		}
+		if (!pipeline->read_errors) {
+			pipeline->read_errors = g_string_new(saves[i].name);
+		} else {
+			g_string_append_printf(pipeline->read_errors, ", %s", saves[i].name);
+		}
+	}
+
+	pipeline_status(pipeline, _("Saving..."));
+	for (int i = 0; i < BACKEND_NR; i++) {
+		if (!changed[i] || !saves[i].func) {
+			continue;
+		}
+		struct save_job *job = g_new0(struct save_job, 1);
+		job->pipeline = pipeline;
+		job->backend = i;
+		job->save = &saves[i];
+		GTask *task = g_task_new(NULL, NULL, save_done, pipeline);
+		g_task_set_task_data(task, job, g_free);
+		g_task_run_in_thread(task, save_thread);
+		g_object_unref(task);
+		pipeline->nr_saving++;
+	}
+	if (!pipeline->nr_saving) {
+		pipeline_saved(pipeline);
 	}
 }
 
+/* called on the main thread once all files have been saved */
+static void
+pipeline_saved(struct pipeline *pipeline)
+{
+	/* do not reconfigure labwc with half of the changes */
+	if (pipeline->save_errors) {
+		char *error = g_strdup_printf(_("cannot save %s"), pipeline->save_errors->str);
+		pipeline_done(pipeline, error);
+		g_free(error);
+		return;
+	}
+
+	/* the openbox theme called "GTK" is generated from the gtk theme */
+	bool reconfigure = pipeline->reconfigure;
+	if (pipeline->gtk_theme) {
+		gint64 start = trace_begin();
+		const char *previous = watchdog_begin("generating GTK theme");
+		bool generated = gtktheme_generate(pipeline->gtk_theme,
+			pipeline->gtk_theme_filename);
+		watchdog_end(previous);
+		trace_end(start, "gtktheme_generate");
+		/* labwc is still reconfigured with the other changes if this fails */
+		if (!generated) {
+			pipeline_add(pipeline, _("Generating theme from GTK theme..."), NULL,
+				"labwc-gtktheme.py", NULL, true);
+		}
+		reconfigure = true;
+	}
+
+	/* each reconfigure makes every output hitch, so only do it when needed */
+	if (reconfigure) {
+		pipeline_add(pipeline, _("Reconfiguring labwc..."), reconfigure_labwc,
+			"labwc", "-r", false);
+	}
+
+	pipeline_run_step(pipeline);
+}
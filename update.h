@@ -3,6 +3,27 @@
 #define UPDATE_H
 #include <gtk/gtk.h>
 
+struct state;
+
+/**
+ * update_init - prepare the snapshot of the values of all settings widgets
+ * update() compares against the snapshot so that only changed settings are
+ * written, and labwc is only reconfigured if rc.xml, environment or
+ * themerc-override have changed.
+ */
+void update_init(struct state *state);
+void update_finish(struct state *state);
+
+/**
+ * update_add_widgets - take the values of newly built settings widgets
+ * Call after building a page. Settings on pages which have not been built
+ * are left alone by update(). While the state->widgets.auto_apply check
+ * button is active, changes to the widgets call update() once none has been
+ * made for state->debounce_ms, so dragging a spin button results in one
+ * write and one reconfigure.
+ */
+void update_add_widgets(struct state *state);
+
 void update(GtkWidget *widget, gpointer data);
 
 #endif /* UPDATE_H */
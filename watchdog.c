@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "watchdog.h"
+
+/* upper bounds in multiples of the threshold; the last bucket is open-ended */
+static const int bucket_factors[WATCHDOG_NR_BUCKETS - 1] = { 2, 4, 8, 16, 32, 64, 128 };
+
+static struct {
+	GThread *thread;
+	GMutex mutex;
+	GCond cond;
+	bool quit;
+	guint source;
+
+	gint64 threshold; /* us */
+	gint64 interval; /* us, between heartbeats */
+	gint64 last_beat;
+	gint64 reported_beat; /* last_beat of the stall already warned about */
+
+	const char *operation;
+	gint64 operation_start;
+	const char *stall_operation; /* blamed for the current stall */
+
+	guint counts[WATCHDOG_NR_BUCKETS];
+} wd;
+
+static void
+record_stall(gint64 duration)
+{
+	int i = 0;
+	while (i < WATCHDOG_NR_BUCKETS - 1 && duration >= wd.threshold * bucket_factors[i]) {
+		i++;
+	}
+	wd.counts[i]++;
+}
+
+/* runs on the main thread: each call proves the main loop is iterating */
+static gboolean
+heartbeat(gpointer data)
+{
+	gint64 now = g_get_monotonic_time();
+
+	g_mutex_lock(&wd.mutex);
+	gint64 stall = now - wd.last_beat - wd.interval;
+	if (stall >= wd.threshold) {
+		record_stall(stall);
+		fprintf(stderr, "warn: main loop stalled for %d ms in %s\n", (int)(stall / 1000),
+			wd.stall_operation ? wd.stall_operation : "unknown operation");
+	}
+	wd.last_beat = now;
+	wd.stall_operation = NULL;
+	g_mutex_unlock(&wd.mutex);
+	return G_SOURCE_CONTINUE;
+}
+
+static gpointer
+watch(gpointer data)
+{
+	g_mutex_lock(&wd.mutex);
+	while (!wd.quit) {
+		gint64 now = g_get_monotonic_time();
+		if (now - wd.last_beat - wd.interval >= wd.threshold
+				&& wd.reported_beat != wd.last_beat) {
+			/* warn while the stall is going on in case it never ends */
+			wd.reported_beat = wd.last_beat;
+			wd.stall_operation = wd.operation;
+			if (wd.operation) {
+				fprintf(stderr, "warn: main loop stalled in %s, running for %d ms\n",
+					wd.operation, (int)((now - wd.operation_start) / 1000));
+			} else {
+				fprintf(stderr, "warn: main loop stalled\n");
+			}
+		}
+		g_cond_wait_until(&wd.cond, &wd.mutex, now + wd.interval);
+	}
+	g_mutex_unlock(&wd.mutex);
+	return NULL;
+}
+
+void
+watchdog_init(int threshold_ms)
+{
+	if (!threshold_ms) {
+		const char *env = g_getenv("LABWC_TWEAKS_WATCHDOG");
+		threshold_ms = env ? atoi(env) : 0;
+	}
+	if (threshold_ms <= 0 || wd.thread) {
+		return;
+	}
+	wd.threshold = threshold_ms * G_GINT64_CONSTANT(1000);
+	wd.interval = MAX(wd.threshold / 2, 10000);
+	wd.last_beat = g_get_monotonic_time();
+	wd.quit = false;
+	memset(wd.counts, 0, sizeof(wd.counts));
+	wd.source = g_timeout_add(wd.interval / 1000, heartbeat, NULL);
+	wd.thread = g_thread_new("watchdog", watch, NULL);
+}
+
+void
+watchdog_get_histogram(guint counts[WATCHDOG_NR_BUCKETS], int upper_ms[WATCHDOG_NR_BUCKETS])
+{
+	g_mutex_lock(&wd.mutex);
+	for (int i = 0; i < WATCHDOG_NR_BUCKETS; i++) {
+		counts[i] = wd.counts[i];
+		if (upper_ms) {
+			upper_ms[i] = i < WATCHDOG_NR_BUCKETS - 1
+				? (int)(wd.threshold / 1000) * bucket_factors[i] : 0;
+		}
+	}
+	g_mutex_unlock(&wd.mutex);
+}
+
+void
+watchdog_finish(void)
+{
+	if (!wd.thread) {
+		return;
+	}
+	g_mutex_lock(&wd.mutex);
+	wd.quit = true;
+	g_cond_signal(&wd.cond);
+	g_mutex_unlock(&wd.mutex);
+	g_thread_join(wd.thread);
+	wd.thread = NULL;
+	g_source_remove(wd.source);
+	wd.source = 0;
+
+	guint counts[WATCHDOG_NR_BUCKETS];
+	int upper_ms[WATCHDOG_NR_BUCKETS];
+	watchdog_get_histogram(counts, upper_ms);
+	fprintf(stderr, "main loop stalls:\n");
+	int lower_ms = (int)(wd.threshold / 1000);
+	for (int i = 0; i < WATCHDOG_NR_BUCKETS; i++) {
+		if (upper_ms[i]) {
+			fprintf(stderr, "  %5d - %5d ms: %u\n", lower_ms, upper_ms[i], counts[i]);
+		} else {
+			fprintf(stderr, "  %5d+        ms: %u\n", lower_ms, counts[i]);
+		}
+		lower_ms = upper_ms[i];
+	}
+}
+
+const char *
+watchdog_begin(const char *name)
+{
+	g_mutex_lock(&wd.mutex);
+	const char *previous = wd.operation;
+	wd.operation = name;
+	wd.operation_start = g_get_monotonic_time();
+	g_mutex_unlock(&wd.mutex);
+	return previous;
+}
+
+void
+watchdog_end(const char *previous)
+{
+	g_mutex_lock(&wd.mutex);
+	/* blame operations which end before the watchdog thread notices */
+	if (!wd.stall_operation && wd.threshold
+			&& g_get_monotonic_time() - wd.operation_start >= wd.threshold) {
+		wd.stall_operation = wd.operation;
+	}
+	wd.operation = previous;
+	g_mutex_unlock(&wd.mutex);
+}
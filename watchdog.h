@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+#include <glib.h>
+
+#define WATCHDOG_NR_BUCKETS 8
+
+/**
+ * watchdog_init - watch the default main context for stalls
+ * @threshold_ms: shortest stall to report, or 0 to use $LABWC_TWEAKS_WATCHDOG
+ *		  and do nothing if that is not set either
+ *
+ * A timeout on the main context records each iteration, and a thread warns
+ * when none has happened within @threshold_ms, naming the operation set by
+ * watchdog_begin() and how long it has been running. Stalls are counted in a
+ * histogram which watchdog_finish() prints.
+ */
+void watchdog_init(int threshold_ms);
+void watchdog_finish(void);
+
+/**
+ * watchdog_begin - name the operation the main thread is about to block on
+ * @name: a string which stays valid, usually a literal
+ * Returns the operation in flight before, to pass to watchdog_end()
+ */
+const char *watchdog_begin(const char *name);
+void watchdog_end(const char *previous);
+
+/**
+ * watchdog_get_histogram - number of stalls by duration
+ * @upper_ms: if not NULL, receives the upper bound of each bucket; the last
+ *	      bucket is unbounded and has an upper bound of 0
+ */
+void watchdog_get_histogram(guint counts[WATCHDOG_NR_BUCKETS],
+	int upper_ms[WATCHDOG_NR_BUCKETS]);
+
+#endif /* WATCHDOG_H */
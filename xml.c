@@ -149,7 +149,6 @@ xml_setup_nodes(void)
 	xpath_add_node("/labwc_config/theme/cornerRadius");
 	xpath_add_node("/labwc_config/theme/name");
 	xpath_add_node("/labwc_config/libinput/device/naturalScroll");
-	xml_save();
 }
 
 void
@@ -175,9 +174,40 @@ xml_init(const char *filename)
 }
 
 void
+xml_init_from_data(const char *filename, const char *data, int size)
+{
+	LIBXML_TEST_VERSION
+
+	/* a missing file is written with the first xml_save() */
+	if (!data) {
+		data = rcxml_template;
+		size = sizeof(rcxml_template) - 1;
+	}
+	ctx.filename = strdup(filename);
+	ctx.doc = xmlReadMemory(data, size, filename, NULL, XML_PARSE_NOBLANKS);
+	if (!ctx.doc) {
+		fprintf(stderr, "warn: xmlReadMemory('%s')\n", filename);
+	}
+	ctx.xpath_ctx_ptr = xmlXPathNewContext(ctx.doc);
+	if (!ctx.xpath_ctx_ptr) {
+		fprintf(stderr, "warn: xmlXPathNewContext()\n");
+		xmlFreeDoc(ctx.doc);
+	}
+}
+
+bool
 xml_save(void)
 {
-	xmlSaveFormatFile(ctx.filename, ctx.doc, 1);
+	/* rc.xml is only read at startup, so ~/.config/labwc may not exist yet */
+	char *dir = g_path_get_dirname(ctx.filename);
+	g_mkdir_with_parents(dir, 0755);
+	g_free(dir);
+
+	if (xmlSaveFormatFile(ctx.filename, ctx.doc, 1) < 0) {
+		fprintf(stderr, "warn: cannot save %s\n", ctx.filename);
+		return false;
+	}
+	return true;
 }
 
 void
@@ -218,6 +248,8 @@ xml_set_num(char *nodename, double value)
 char *
 xml_get(char *nodename)
 {
+	/* do not return whatever xml_set() was last called with */
+	ctx.value = NULL;
 	ctx.nodename = nodename;
 	ctx.mode = XML_MODE_GETTING;
 	xml_tree_walk(xmlDocGetRootElement(ctx.doc));
@@ -227,6 +259,7 @@ xml_get(char *nodename)
 int
 xml_get_int(char *nodename)
 {
+	ctx.value = NULL;
 	ctx.nodename = nodename;
 	ctx.mode = XML_MODE_GETTING;
 	xml_tree_walk(xmlDocGetRootElement(ctx.doc));
@@ -1,10 +1,19 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 #ifndef __XML_H
 #define __XML_H
+#include <stdbool.h>
 
 void xml_setup_nodes(void);
 void xml_init(const char *filename);
-void xml_save(void);
+
+/**
+ * xml_init_from_data - as xml_init() with the file already read
+ * @data: contents of @filename, or NULL if it does not exist yet
+ */
+void xml_init_from_data(const char *filename, const char *data, int size);
+
+/* returns false on error */
+bool xml_save(void);
 void xml_save_as(const char *filename);
 void xml_finish(void);
 void xml_set(char *nodename, char *value);